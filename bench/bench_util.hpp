@@ -0,0 +1,162 @@
+/**
+ * @file bench_util.hpp
+ * @brief Shared helpers for the RingBuffer benchmarks: thread pinning, CPU topology and latency histograms
+ */
+
+#ifndef RINGBUFFER_BENCH_UTIL_HPP
+#define RINGBUFFER_BENCH_UTIL_HPP
+
+#include "ringbuffer.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+/**
+ * @brief Monotonic timestamp in nanoseconds
+ * @return The current time
+ */
+inline uint64_t NowNanoseconds() noexcept {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+/**
+ * @brief Pin the calling thread to one CPU
+ * @param cpu The CPU, or -1 to leave the thread unpinned
+ * @return Whether the thread runs pinned
+ */
+inline bool PinThread(int cpu) noexcept {
+#if defined(__linux__)
+    if (cpu < 0) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+/**
+ * @brief Producer/consumer CPU pair with a human readable description of how they relate
+ */
+struct Placement {
+    std::string name; // e.g. "SMT sibling"
+    int producerCpu; // CPU the producer is pinned to, -1 for unpinned
+    int consumerCpu; // CPU the consumer is pinned to, -1 for unpinned
+};
+
+/**
+ * @brief Read one integer from a sysfs topology file
+ * @param cpu The CPU
+ * @param file The file below /sys/devices/system/cpu/cpuN/topology
+ * @return The value, or -1 if unavailable
+ */
+inline int ReadTopology(int cpu, const char* file) noexcept {
+    char path[128];
+    std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, file);
+    int value = -1;
+    if (auto* stream = std::fopen(path, "r")) {
+        if (std::fscanf(stream, "%d", &value) != 1) {
+            value = -1;
+        }
+        std::fclose(stream);
+    }
+    return value;
+}
+
+/**
+ * @brief Pick CPU pairs for the placements available on this machine, relative to CPU 0
+ * @return The unpinned placement followed by SMT sibling, same socket and cross socket when present
+ */
+inline std::vector<Placement> DetectPlacements() {
+    std::vector<Placement> placements{{"unpinned", -1, -1}};
+#if defined(__linux__)
+    const int cpus = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+    const int core = ReadTopology(0, "core_id");
+    const int package = ReadTopology(0, "physical_package_id");
+    int sibling = -1;
+    int sameSocket = -1;
+    int crossSocket = -1;
+    for (int cpu = 1; cpu < cpus; ++cpu) {
+        const int cpuCore = ReadTopology(cpu, "core_id");
+        const int cpuPackage = ReadTopology(cpu, "physical_package_id");
+        if (cpuPackage == package && cpuCore == core && sibling < 0) {
+            sibling = cpu;
+        } else if (cpuPackage == package && cpuCore != core && sameSocket < 0) {
+            sameSocket = cpu;
+        } else if (cpuPackage != package && crossSocket < 0) {
+            crossSocket = cpu;
+        }
+    }
+    if (sibling >= 0) {
+        placements.push_back({"SMT sibling", 0, sibling});
+    }
+    if (sameSocket >= 0) {
+        placements.push_back({"same socket", 0, sameSocket});
+    }
+    if (crossSocket >= 0) {
+        placements.push_back({"cross socket", 0, crossSocket});
+    }
+#endif
+    return placements;
+}
+
+/**
+ * @brief Round-trip latency histogram in nanoseconds, one sub-bucket bit finer than residency tracing
+ */
+using LatencyHistogram = BasicRingBufferLatencyHistogram<6>;
+
+/**
+ * @brief Bounded std::deque behind a mutex, the baseline every RingBuffer is compared with
+ */
+template <typename T>
+class MutexDeque {
+public:
+    explicit MutexDeque(size_t capacity) : capacity_(capacity) {}
+
+    bool Write(const T& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.size() == capacity_) {
+            return false;
+        }
+        queue_.push_back(value);
+        return true;
+    }
+
+    bool Read(T& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.empty()) {
+            return false;
+        }
+        value = queue_.front();
+        queue_.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex mutex_;
+    std::deque<T> queue_;
+    size_t capacity_;
+};
+
+} // namespace bench
+
+#endif // RINGBUFFER_BENCH_UTIL_HPP
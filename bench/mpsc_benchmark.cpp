@@ -0,0 +1,114 @@
+/**
+ * @file mpsc_benchmark.cpp
+ * @brief Many producers feeding one consumer: MPSCRingBuffer against a mutex-wrapped RingBuffer
+ *
+ * Build: g++ -std=c++17 -O2 -pthread -I. bench/mpsc_benchmark.cpp -o mpsc_benchmark
+ * Usage: ./mpsc_benchmark [messages per producer] [max producers]
+ */
+
+#include "ringbuffer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t BufferCapacity = 4096;
+
+struct Message {
+    size_t producer;
+    size_t sequence;
+};
+
+/**
+ * @brief The SPSC RingBuffer shared by all producers behind a mutex, the setup MPSCRingBuffer replaces
+ */
+class MutexRingBuffer {
+public:
+    bool Write(const Message& value) noexcept {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return buffer_.Write(value);
+    }
+
+    bool Read(Message& value) noexcept {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return buffer_.Read(value);
+    }
+
+private:
+    std::mutex mutex_;
+    RingBuffer<Message, BufferCapacity> buffer_;
+};
+
+/**
+ * @brief Run producers against one consumer until every message has been drained
+ * @param producers The number of producer threads
+ * @param messages The number of messages written by each producer
+ * @return Throughput in millions of messages per second
+ */
+template <typename Buffer>
+double Run(size_t producers, size_t messages) {
+    auto buffer = std::make_unique<Buffer>();
+    std::atomic<bool> start{false};
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            while (!start.load(std::memory_order_acquire)) {
+                ringbuffer_detail::CpuRelax();
+            }
+            for (size_t i = 0; i < messages;) {
+                if (buffer->Write(Message{p, i})) {
+                    ++i;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<size_t> expected(producers, 0);
+    const auto total = producers * messages;
+    const auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    Message message;
+    for (size_t received = 0; received < total;) {
+        if (buffer->Read(message)) {
+            if (message.sequence != expected[message.producer]++) {
+                std::fprintf(stderr, "out of order message from producer %zu\n", message.producer);
+                std::exit(1);
+            }
+            ++received;
+        } else {
+            ringbuffer_detail::CpuRelax();
+        }
+    }
+    const auto end = std::chrono::steady_clock::now();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const auto seconds = std::chrono::duration<double>(end - begin).count();
+    return static_cast<double>(total) / seconds / 1e6;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t messages = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    const size_t maxProducers = argc > 2 ? std::strtoull(argv[2], nullptr, 10)
+                                         : std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+    std::printf("%-10s %18s %18s\n", "producers", "MPSC (Mops/s)", "mutex (Mops/s)");
+    for (size_t producers = 1; producers <= maxProducers; producers *= 2) {
+        const auto mpsc = Run<MPSCRingBuffer<Message, BufferCapacity>>(producers, messages);
+        const auto mutex = Run<MutexRingBuffer>(producers, messages);
+        std::printf("%-10zu %18.2f %18.2f\n", producers, mpsc, mutex);
+    }
+    return 0;
+}
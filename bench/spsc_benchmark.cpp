@@ -0,0 +1,245 @@
+/**
+ * @file spsc_benchmark.cpp
+ * @brief SPSC throughput and round-trip latency of RingBuffer against a mutex-protected std::deque
+ *
+ * Runs every combination of element size (8B-4KB), capacity and core placement (unpinned, SMT
+ * sibling, same socket, cross socket, as detected from sysfs). Throughput streams messages from
+ * a producer to a consumer; latency bounces one message between two threads through a pair of
+ * buffers and reports round-trip percentiles. RingBuffer runs both with a runtime capacity (row
+ * "RingBuffer") and with the capacity as a template argument and inline slots (row "fixed"), the
+ * latter also with consumer and producer prefetching at a few distances (rows "fixed+pfN"), to
+ * tune Traits::PrefetchDistance per element size. Row "no-membar" repeats "fixed" with membarrier
+ * treated as unavailable, so every publish pays the full fence in front of the wake-up check, and
+ * row "no-park" sets Traits::Parking to false, dropping that check altogether.
+ *
+ * Build: g++ -std=c++17 -O2 -pthread -I. bench/spsc_benchmark.cpp -o spsc_benchmark
+ * Usage: ./spsc_benchmark [messages] [round trips]
+ */
+
+#include "ringbuffer.hpp"
+#include "bench_util.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+
+namespace {
+
+/**
+ * @brief Message of Size bytes whose first 8 bytes carry a sequence number
+ */
+template <size_t Size>
+struct Payload {
+    uint64_t sequence;
+    unsigned char padding[Size - sizeof(uint64_t)];
+};
+
+template <>
+struct Payload<sizeof(uint64_t)> {
+    uint64_t sequence;
+};
+
+/**
+ * @brief RingBuffer traits prefetching Distance slots ahead on both sides
+ */
+template <size_t Distance>
+struct PrefetchTraits : DefaultRingBufferTraits {
+    static constexpr size_t PrefetchDistance = Distance;
+    static constexpr bool PrefetchForWrite = true;
+};
+
+/**
+ * @brief RingBuffer traits that never park, so publishing skips the wake-up check
+ */
+struct NoParkingTraits : DefaultRingBufferTraits {
+    using WaitStrategy = BusySpinWait;
+    static constexpr bool Parking = false;
+};
+
+/**
+ * @brief Results of one configuration
+ */
+struct Result {
+    double throughput; // Millions of messages per second
+    uint64_t p50; // Round-trip latency percentiles in nanoseconds
+    uint64_t p99;
+    uint64_t p999;
+};
+
+/**
+ * @brief Stream messages from a pinned producer to a pinned consumer
+ * @param makeBuffer Creates the buffer under test
+ * @param placement The CPUs to run on
+ * @param messages The number of messages
+ * @return Throughput in millions of messages per second
+ */
+template <typename Message, typename MakeBuffer>
+double MeasureThroughput(MakeBuffer&& makeBuffer, const bench::Placement& placement, size_t messages) {
+    auto buffer = makeBuffer();
+    std::atomic<bool> ready{false};
+    std::thread consumer([&] {
+        bench::PinThread(placement.consumerCpu);
+        ready.store(true, std::memory_order_release);
+        Message message{};
+        for (uint64_t expected = 0; expected < messages;) {
+            if (buffer->Read(message)) {
+                if (message.sequence != expected++) {
+                    std::fprintf(stderr, "out of order message\n");
+                    std::exit(1);
+                }
+            } else {
+                ringbuffer_detail::CpuRelax();
+            }
+        }
+    });
+    bench::PinThread(placement.producerCpu);
+    while (!ready.load(std::memory_order_acquire)) {
+        ringbuffer_detail::CpuRelax();
+    }
+    Message message{};
+    const auto begin = bench::NowNanoseconds();
+    for (uint64_t sequence = 0; sequence < messages;) {
+        message.sequence = sequence;
+        if (buffer->Write(message)) {
+            ++sequence;
+        } else {
+            ringbuffer_detail::CpuRelax();
+        }
+    }
+    consumer.join();
+    const auto elapsed = bench::NowNanoseconds() - begin;
+    bench::PinThread(-1);
+    return static_cast<double>(messages) * 1e3 / static_cast<double>(elapsed);
+}
+
+/**
+ * @brief Bounce one message between two pinned threads and record every round trip
+ * @param makeBuffer Creates one of the two buffers under test
+ * @param placement The CPUs to run on
+ * @param roundTrips The number of round trips
+ * @return The round-trip latency histogram in nanoseconds
+ */
+template <typename Message, typename MakeBuffer>
+bench::LatencyHistogram MeasureLatency(MakeBuffer&& makeBuffer, const bench::Placement& placement,
+                                       size_t roundTrips) {
+    auto ping = makeBuffer();
+    auto pong = makeBuffer();
+    std::thread echo([&] {
+        bench::PinThread(placement.consumerCpu);
+        Message message{};
+        for (size_t i = 0; i < roundTrips; ++i) {
+            while (!ping->Read(message)) {
+                ringbuffer_detail::CpuRelax();
+            }
+            while (!pong->Write(message)) {
+                ringbuffer_detail::CpuRelax();
+            }
+        }
+    });
+    bench::PinThread(placement.producerCpu);
+    bench::LatencyHistogram histogram;
+    Message message{};
+    for (size_t i = 0; i < roundTrips; ++i) {
+        message.sequence = i;
+        const auto begin = bench::NowNanoseconds();
+        while (!ping->Write(message)) {
+            ringbuffer_detail::CpuRelax();
+        }
+        while (!pong->Read(message)) {
+            ringbuffer_detail::CpuRelax();
+        }
+        histogram.Record(bench::NowNanoseconds() - begin);
+    }
+    echo.join();
+    bench::PinThread(-1);
+    return histogram;
+}
+
+template <typename Message, typename MakeBuffer>
+Result Measure(MakeBuffer&& makeBuffer, const bench::Placement& placement, size_t messages, size_t roundTrips) {
+    const auto throughput = MeasureThroughput<Message>(makeBuffer, placement, messages);
+    const auto latency = MeasureLatency<Message>(makeBuffer, placement, roundTrips);
+    return Result{throughput, latency.Percentile(0.5), latency.Percentile(0.99), latency.Percentile(0.999)};
+}
+
+/**
+ * @brief Measure as on a system without membarrier, where LightBarrier() is a full fence
+ */
+template <typename Message, typename MakeBuffer>
+Result MeasureWithoutMembarrier(MakeBuffer&& makeBuffer, const bench::Placement& placement, size_t messages,
+                                size_t roundTrips) {
+    // No thread touches a RingBuffer between measurements, so the process-wide state can be switched here
+    ringbuffer_detail::InitAsymmetricBarrier();
+    auto& state = ringbuffer_detail::MembarrierState();
+    const auto previous = state.exchange(2);
+    const auto result = Measure<Message>(makeBuffer, placement, messages, roundTrips);
+    state.store(previous);
+    return result;
+}
+
+void PrintResult(const char* queue, size_t size, size_t capacity, const bench::Placement& placement,
+                 const Result& result) {
+    std::printf("%-10s %6zu %8zu  %-13s %10.2f %12.3f %8llu %8llu %8llu\n", queue, size, capacity,
+                placement.name.c_str(), result.throughput,
+                result.throughput * static_cast<double>(size) / 1e3, static_cast<unsigned long long>(result.p50),
+                static_cast<unsigned long long>(result.p99), static_cast<unsigned long long>(result.p999));
+}
+
+template <size_t Size, size_t Capacity>
+void RunCapacity(const std::vector<bench::Placement>& placements, size_t messages, size_t roundTrips) {
+    using Message = Payload<Size>;
+    for (const auto& placement : placements) {
+        const auto ring = Measure<Message>(
+            [&] { return std::make_unique<RingBuffer<Message, DynamicCapacity>>(Capacity); }, placement, messages,
+            roundTrips);
+        PrintResult("RingBuffer", Size, Capacity, placement, ring);
+        const auto fixed = Measure<Message>([&] { return std::make_unique<RingBuffer<Message, Capacity>>(); },
+                                            placement, messages, roundTrips);
+        PrintResult("fixed", Size, Capacity, placement, fixed);
+        const auto fence = MeasureWithoutMembarrier<Message>(
+            [&] { return std::make_unique<RingBuffer<Message, Capacity>>(); }, placement, messages, roundTrips);
+        PrintResult("no-membar", Size, Capacity, placement, fence);
+        const auto noPark = Measure<Message>(
+            [&] { return std::make_unique<RingBuffer<Message, Capacity, NoParkingTraits>>(); }, placement,
+            messages, roundTrips);
+        PrintResult("no-park", Size, Capacity, placement, noPark);
+        const auto near = Measure<Message>(
+            [&] { return std::make_unique<RingBuffer<Message, Capacity, PrefetchTraits<2>>>(); }, placement,
+            messages, roundTrips);
+        PrintResult("fixed+pf2", Size, Capacity, placement, near);
+        const auto far = Measure<Message>(
+            [&] { return std::make_unique<RingBuffer<Message, Capacity, PrefetchTraits<8>>>(); }, placement,
+            messages, roundTrips);
+        PrintResult("fixed+pf8", Size, Capacity, placement, far);
+        const auto deque = Measure<Message>(
+            [&] { return std::make_unique<bench::MutexDeque<Message>>(Capacity); }, placement, messages,
+            roundTrips);
+        PrintResult("deque", Size, Capacity, placement, deque);
+    }
+}
+
+template <size_t Size>
+void RunElementSize(const std::vector<bench::Placement>& placements, size_t messages, size_t roundTrips) {
+    RunCapacity<Size, 64>(placements, messages, roundTrips);
+    RunCapacity<Size, 1024>(placements, messages, roundTrips);
+    RunCapacity<Size, 16384>(placements, messages, roundTrips);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t messages = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+    const size_t roundTrips = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200000;
+    const auto placements = bench::DetectPlacements();
+
+    std::printf("%-10s %6s %8s  %-13s %10s %12s %8s %8s %8s\n", "queue", "bytes", "capacity", "placement",
+                "Mops/s", "GB/s", "p50(ns)", "p99(ns)", "p99.9(ns)");
+    RunElementSize<8>(placements, messages, roundTrips);
+    RunElementSize<64>(placements, messages, roundTrips);
+    RunElementSize<256>(placements, messages, roundTrips);
+    RunElementSize<1024>(placements, messages, roundTrips);
+    RunElementSize<4096>(placements, messages, roundTrips);
+    return 0;
+}
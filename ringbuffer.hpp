@@ -8,16 +8,3784 @@
 #ifndef RINGBUFFER_HPP
 #define RINGBUFFER_HPP
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <type_traits>
+#include <utility>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <linux/membarrier.h>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <ctime>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#if __has_include(<span>)
+#include <span>
+#endif
+#if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+#include <coroutine>
+#define RINGBUFFER_HAS_COROUTINES 1
+#endif
 
+// ThreadSanitizer does not model std::atomic_thread_fence, so the fence-based paths use atomic
+// operations it understands under it instead (see LightBarrier() and SeqlockSlot)
+#if defined(__SANITIZE_THREAD__)
+#define RINGBUFFER_TSAN 1
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define RINGBUFFER_TSAN 1
+#endif
+#endif
+
+#ifndef RINGBUFFER_CACHE_LINE_SIZE
+#ifdef __cpp_lib_hardware_interference_size
+#define RINGBUFFER_CACHE_LINE_SIZE std::hardware_destructive_interference_size
+#else
+#define RINGBUFFER_CACHE_LINE_SIZE 64
+#endif
+#endif
+
+namespace ringbuffer_detail {
+
+/**
+ * @brief Distance that keeps data written by different threads from sharing a cache line
+ * @note Define RINGBUFFER_CACHE_LINE_SIZE, e.g. to 128 to also cover the adjacent-line prefetcher on Intel.
+ *       The default follows the compiler's tuning, so also define it when translation units built with
+ *       different -mtune/-mcpu flags share RingBuffer types
+ */
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 12
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winterference-size"
+#endif
+inline constexpr size_t CacheLineSize = RINGBUFFER_CACHE_LINE_SIZE;
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 12
+#pragma GCC diagnostic pop
+#endif
+static_assert((CacheLineSize & (CacheLineSize - 1)) == 0, "RINGBUFFER_CACHE_LINE_SIZE must be a power of 2.");
+
+/**
+ * @brief Tell the CPU we are in a spin-wait loop, easing pressure on the SMT sibling
+ */
+inline void CpuRelax() noexcept {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+/**
+ * @brief Number of times a blocking operation retries before parking the calling thread
+ */
+constexpr unsigned ParkSpinCount = 256;
+
+/**
+ * @brief Whether the process is registered for expedited private membarrier
+ * @return 0 when not yet probed, 1 when registered, 2 when unavailable
+ */
+inline std::atomic<int>& MembarrierState() noexcept {
+    static std::atomic<int> state{0};
+    return state;
+}
+
+/**
+ * @brief Register the process for expedited private membarrier once, so LightBarrier() can be a compiler fence
+ */
+inline void InitAsymmetricBarrier() noexcept {
+    auto& state = MembarrierState();
+    if (state.load(std::memory_order_acquire) != 0) {
+        return;
+    }
+#if defined(__linux__) && defined(SYS_membarrier)
+    const bool registered = syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+    state.store(registered ? 1 : 2, std::memory_order_release);
+#else
+    state.store(2, std::memory_order_release);
+#endif
+}
+
+#if defined(RINGBUFFER_TSAN)
+/**
+ * @brief Word both barrier halves update under ThreadSanitizer in place of their fences
+ * @return The word
+ * @note Two seq_cst read-modify-writes of one word are ordered, and the later one reads from the
+ *       earlier, so they give the store-load ordering of the fences as a synchronizes-with edge that
+ *       ThreadSanitizer tracks. One word shared by every queue is slow, which only a TSAN build pays
+ */
+inline std::atomic<uint64_t>& SanitizerBarrierWord() noexcept {
+    static std::atomic<uint64_t> word{0};
+    return word;
+}
+#endif
+
+/**
+ * @brief Cheap half of an asymmetric store-load barrier, executed by the side that publishes on every operation
+ *
+ * Pairs with HeavyBarrier(): a publisher that stores an index, runs LightBarrier() and then loads a
+ * waiter flag cannot miss a waiter that set the flag, ran HeavyBarrier() and then loads the index.
+ */
+inline void LightBarrier() noexcept {
+#if defined(RINGBUFFER_TSAN)
+    SanitizerBarrierWord().fetch_add(1, std::memory_order_seq_cst);
+#else
+    if (MembarrierState().load(std::memory_order_relaxed) == 1) {
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+    } else {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+#endif
+}
+
+/**
+ * @brief Expensive half of an asymmetric store-load barrier, executed only by a thread about to park
+ */
+inline void HeavyBarrier() noexcept {
+#if defined(RINGBUFFER_TSAN)
+    SanitizerBarrierWord().fetch_add(1, std::memory_order_seq_cst);
+#else
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+#if defined(__linux__) && defined(SYS_membarrier)
+    if (MembarrierState().load(std::memory_order_relaxed) == 1) {
+        syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+    }
+#endif
+#endif
+}
+
+/**
+ * @brief Sleep until word no longer holds expected, a wake-up arrives, or the deadline passes
+ * @param word The word to wait on
+ * @param expected The value observed before deciding to sleep
+ * @param deadline The deadline, or nullptr to wait without a timeout
+ * @note Spurious returns are allowed, callers re-check their condition
+ */
+template <typename Clock, typename Duration>
+void WaitOnWord(std::atomic<uint32_t>& word, uint32_t expected,
+                const std::chrono::time_point<Clock, Duration>* deadline) noexcept {
+#if defined(__linux__) && defined(SYS_futex)
+    timespec timeout{};
+    if (deadline != nullptr) {
+        const auto remaining = *deadline - Clock::now();
+        if (remaining <= remaining.zero()) {
+            return;
+        }
+        const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count();
+        timeout.tv_sec = static_cast<time_t>(nanoseconds / 1000000000);
+        timeout.tv_nsec = static_cast<long>(nanoseconds % 1000000000);
+    }
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected,
+            deadline != nullptr ? &timeout : nullptr, nullptr, 0);
+#else
+    if (deadline == nullptr) {
+#ifdef __cpp_lib_atomic_wait
+        word.wait(expected, std::memory_order_acquire);
+#else
+        std::this_thread::yield();
+#endif
+    } else if (word.load(std::memory_order_acquire) == expected) {
+        // No portable timed wait on an atomic, poll with short sleeps instead
+        const auto remaining = *deadline - Clock::now();
+        std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(remaining), std::chrono::microseconds(50)));
+    }
+#endif
+}
+
+/**
+ * @brief Wake every thread sleeping in WaitOnWord() on word
+ * @param word The word to wake waiters on
+ */
+inline void WakeOnWord(std::atomic<uint32_t>& word) noexcept {
+#if defined(__linux__) && defined(SYS_futex)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+#elif defined(__cpp_lib_atomic_wait)
+    word.notify_all();
+#else
+    (void)word;
+#endif
+}
+
+/**
+ * @brief Waiter that is called back instead of sleeping, e.g. a suspended coroutine
+ */
+struct AsyncWaiter {
+    void (*wake)(AsyncWaiter* waiter) noexcept; // Called once by the Notify() that claims the waiter
+};
+
+/**
+ * @brief Sleep/wake rendezvous for one side of a queue: waiters park on it, the other side notifies
+ *
+ * The notifier only loads waiters_ on its fast path, behind LightBarrier(). With membarrier
+ * registered that barrier is compiler-only and an unused ParkingLot costs one relaxed load;
+ * where it is unavailable (old kernels, seccomp sandboxes, other systems) it is a full seq_cst
+ * fence on every publish. A RingBuffer whose traits set Parking to false never calls Notify().
+ * Besides any number of sleeping threads, one AsyncWaiter can be registered at a time, which is
+ * all a single-consumer or single-producer side needs.
+ */
+class ParkingLot {
+public:
+    ParkingLot() noexcept : waiters_(0), epoch_(0), asyncWaiter_(nullptr) {}
+
+    /**
+     * @brief Register as a waiter, re-check the condition, and sleep if it still does not hold
+     * @param condition Retried after registering, returns true when the waiter can proceed
+     * @param deadline The deadline, or nullptr to wait without a timeout
+     * @return Whether condition succeeded, otherwise the caller should retry or give up
+     */
+    template <typename Condition, typename Clock, typename Duration>
+    bool Park(Condition&& condition, const std::chrono::time_point<Clock, Duration>* deadline) noexcept {
+        // Acquire keeps the epoch load ahead of registering: an epoch read after a Notify() that
+        // already saw this waiter would make the futex wait below miss that wake-up
+        const auto epoch = epoch_.load(std::memory_order_acquire);
+        waiters_.fetch_add(1, std::memory_order_acq_rel);
+        // Pairs with LightBarrier() in Notify(): either the notifier sees this waiter, or condition sees its publish
+        HeavyBarrier();
+        const bool ready = condition();
+        if (!ready) {
+            WaitOnWord(epoch_, epoch, deadline);
+        }
+        waiters_.fetch_sub(1, std::memory_order_release);
+        return ready;
+    }
+
+    /**
+     * @brief Register an asynchronous waiter, re-check readiness, and leave it registered if still not ready
+     * @param condition Readiness check retried after registering, must not consume anything
+     * @param waiter The waiter, it must stay valid until it is woken
+     * @return Whether condition succeeded and the waiter was withdrawn; otherwise waiter->wake is called
+     *         exactly once by a later Notify()
+     */
+    template <typename Condition>
+    bool ParkAsync(Condition&& condition, AsyncWaiter* waiter) noexcept {
+        waiters_.fetch_add(1, std::memory_order_acq_rel);
+        [[maybe_unused]] const auto* previous = asyncWaiter_.exchange(waiter, std::memory_order_acq_rel);
+        assert(previous == nullptr);
+        // Pairs with LightBarrier() in Notify(), like in Park()
+        HeavyBarrier();
+        if (!condition()) {
+            return false;
+        }
+        if (asyncWaiter_.exchange(nullptr, std::memory_order_acq_rel) != waiter) {
+            // A notifier claimed the waiter first and is about to wake it
+            return false;
+        }
+        waiters_.fetch_sub(1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Whether an AsyncWaiter registered by ParkAsync() is still waiting, i.e. not yet claimed by a Notify()
+     * @param waiter The waiter
+     * @return Whether waiter is still registered
+     */
+    bool IsParked(const AsyncWaiter* waiter) const noexcept {
+        return asyncWaiter_.load(std::memory_order_acquire) == waiter;
+    }
+
+    /**
+     * @brief Whether a thread or AsyncWaiter is registered, for a publisher deciding whether it may hold back a publish
+     * @return Whether any waiter is between registering and leaving
+     * @note Runs LightBarrier() first, so like Notify() it cannot miss a waiter that registered
+     *       before re-checking its condition
+     */
+    bool HasWaiters() noexcept {
+        LightBarrier();
+        return waiters_.load(std::memory_order_relaxed) != 0;
+    }
+
+    /**
+     * @brief Wake parked waiters, called after publishing by the other side
+     */
+    void Notify() noexcept {
+        LightBarrier();
+        auto waiters = waiters_.load(std::memory_order_relaxed);
+        if (waiters == 0) {
+            return;
+        }
+        if (auto* waiter = asyncWaiter_.exchange(nullptr, std::memory_order_acq_rel)) {
+            waiters = waiters_.fetch_sub(1, std::memory_order_relaxed) - 1;
+            waiter->wake(waiter);
+        }
+        if (waiters != 0) {
+            epoch_.fetch_add(1, std::memory_order_release);
+            WakeOnWord(epoch_);
+        }
+    }
+
+private:
+    std::atomic<uint32_t> waiters_; // Number of threads between registering and leaving Park(), plus a registered asyncWaiter_
+    std::atomic<uint32_t> epoch_; // Bumped on every wake-up, the futex word waiters sleep on
+    std::atomic<AsyncWaiter*> asyncWaiter_; // Waiter registered by ParkAsync(), if any
+};
+
+#if defined(__linux__)
+/**
+ * @brief AsyncWaiter that signals an eventfd, letting a consumer wait for data in epoll or io_uring
+ */
+struct NotificationWaiter : AsyncWaiter {
+    NotificationWaiter() noexcept : AsyncWaiter{&Wake} {}
+
+    NotificationWaiter(const NotificationWaiter&) = delete;
+    NotificationWaiter& operator=(const NotificationWaiter&) = delete;
+
+    ~NotificationWaiter() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    /**
+     * @brief Register on lot so the next publish signals fd, unless condition already holds
+     * @param lot The parking lot notified on publish
+     * @param condition Readiness check, must not consume anything
+     * @return Whether the caller may wait on fd; false means condition holds now
+     */
+    template <typename Condition>
+    bool Arm(ParkingLot& lot, Condition&& condition) noexcept {
+        if (armed) {
+            if (lot.IsParked(this)) {
+                // Still registered and nothing was published since, so the condition still fails
+                return true;
+            }
+            // Claimed by a Notify(): its write to fd may still be in flight, and draining before it
+            // lands would leave fd readable while registered again, so every poll would return at once
+            while (!signaled.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            uint64_t count;
+            [[maybe_unused]] const auto bytes = read(fd, &count, sizeof(count));
+            signaled.store(false, std::memory_order_relaxed);
+            armed = false;
+        }
+        if (lot.ParkAsync(condition, this)) {
+            return false;
+        }
+        armed = true;
+        return true;
+    }
+
+    static void Wake(AsyncWaiter* waiter) noexcept {
+        auto* self = static_cast<NotificationWaiter*>(waiter);
+        const uint64_t one = 1;
+        [[maybe_unused]] const auto bytes = write(self->fd, &one, sizeof(one));
+        // Only after the write, so an Arm() that sees the flag finds fd readable and drains it
+        self->signaled.store(true, std::memory_order_release);
+    }
+
+    int fd = -1; // The eventfd, -1 until enabled
+    bool armed = false; // Whether the waiter is registered or was woken since, owned by the consumer
+    std::atomic<bool> signaled{false}; // Whether the Notify() that claimed the waiter has written to fd
+};
+#endif
+
+/**
+ * @brief Retry op until it succeeds or the deadline passes: spin first, then park on lot
+ * @param op The non-blocking operation to retry
+ * @param lot The parking lot notified when op may succeed
+ * @param deadline The deadline, or nullptr to wait without a timeout
+ * @return Whether op succeeded
+ */
+template <typename Op, typename Clock, typename Duration>
+bool BlockUntil(Op&& op, ParkingLot& lot, const std::chrono::time_point<Clock, Duration>* deadline) noexcept {
+    for (unsigned spin = 0; spin < ParkSpinCount; ++spin) {
+        if (op()) {
+            return true;
+        }
+        CpuRelax();
+    }
+    for (;;) {
+        if (deadline != nullptr && Clock::now() >= *deadline) {
+            return op();
+        }
+        if (lot.Park(op, deadline)) {
+            return true;
+        }
+    }
+}
+
+} // namespace ringbuffer_detail
+
+/**
+ * @brief Traits::NonTemporalCopyThreshold value streaming exactly the bulk copies larger than the L2 cache
+ */
+inline constexpr size_t NonTemporalAboveL2 = static_cast<size_t>(-1);
+
+/**
+ * @brief Capacity value selecting a RingBuffer whose capacity is chosen at construction
+ */
+inline constexpr size_t DynamicCapacity = static_cast<size_t>(-1);
+
+/**
+ * @brief Allocates the slot array of a dynamic-capacity RingBuffer
+ *
+ * Small value type choosing where the slots live: the regular heap, anonymous mappings backed by
+ * 2MB/1GB huge pages, optionally bound to one NUMA node, or user-supplied functions. The choice
+ * is only consulted at construction and destruction, never on the hot path.
+ */
+class SlotAllocator {
+public:
+    enum class PageSize {
+        Default, // Regular pages
+        Huge2MB, // 2MB huge pages
+        Huge1GB, // 1GB huge pages
+    };
+
+    using AllocateFn = void* (*)(size_t bytes, size_t alignment, void* context);
+    using DeallocateFn = void (*)(void* memory, size_t bytes, size_t alignment, void* context);
+
+    /**
+     * @brief Allocate from the regular heap with aligned operator new
+     * @return The allocator
+     */
+    static SlotAllocator Heap() noexcept { return SlotAllocator(); }
+
+    /**
+     * @brief Allocate whole pages with mmap, optionally huge pages and bound to a NUMA node
+     * @param pageSize The page size to back the slots with
+     * @param numaNode The NUMA node to bind the pages to, or -1 to leave placement to the kernel
+     * @return The allocator
+     * @note Huge pages fall back to transparent huge pages via madvise when none are reserved,
+     *       and to the heap on platforms without mmap
+     */
+    static SlotAllocator Pages(PageSize pageSize, int numaNode = -1) noexcept {
+        SlotAllocator allocator;
+        allocator.mapped_ = true;
+        allocator.pageSize_ = pageSize;
+        allocator.numaNode_ = numaNode;
+        return allocator;
+    }
+
+    /**
+     * @brief Allocate through user-supplied functions
+     * @param allocate Returns memory for bytes with the given alignment, or nullptr on failure
+     * @param deallocate Releases memory returned by allocate
+     * @param context Passed through to both functions
+     * @return The allocator
+     */
+    static SlotAllocator Custom(AllocateFn allocate, DeallocateFn deallocate, void* context = nullptr) noexcept {
+        SlotAllocator allocator;
+        allocator.allocate_ = allocate;
+        allocator.deallocate_ = deallocate;
+        allocator.context_ = context;
+        return allocator;
+    }
+
+    /**
+     * @brief NUMA node of the CPU the calling thread runs on, call it from the consumer thread
+     * @return The node, or -1 when unknown
+     */
+    static int CurrentNumaNode() noexcept {
+#if defined(__linux__) && defined(SYS_getcpu)
+        unsigned cpu = 0;
+        unsigned node = 0;
+        if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+            return static_cast<int>(node);
+        }
+#endif
+        return -1;
+    }
+
+    /**
+     * @brief Allocate memory for the slot array
+     * @param bytes The number of bytes
+     * @param alignment The required alignment
+     * @return The memory, or nullptr on failure
+     */
+    void* Allocate(size_t bytes, size_t alignment) const noexcept {
+        if (allocate_ != nullptr) {
+            return allocate_(bytes, alignment, context_);
+        }
+#if defined(__linux__)
+        if (mapped_) {
+            return MapPages(bytes);
+        }
+#endif
+        return ::operator new(bytes, std::align_val_t(alignment), std::nothrow);
+    }
+
+    /**
+     * @brief Release memory returned by Allocate() with the same arguments
+     * @param memory The memory
+     * @param bytes The number of bytes passed to Allocate()
+     * @param alignment The alignment passed to Allocate()
+     */
+    void Deallocate(void* memory, size_t bytes, size_t alignment) const noexcept {
+        if (deallocate_ != nullptr) {
+            deallocate_(memory, bytes, alignment, context_);
+            return;
+        }
+#if defined(__linux__)
+        if (mapped_) {
+            munmap(memory, RoundUpToPage(bytes));
+            return;
+        }
+#endif
+        ::operator delete(memory, std::align_val_t(alignment));
+    }
+
+private:
+    SlotAllocator() noexcept = default;
+
+#if defined(__linux__)
+    /**
+     * @brief Size of the pages backing the mapping
+     * @return The page size in bytes
+     */
+    size_t PageBytes() const noexcept {
+        switch (pageSize_) {
+        case PageSize::Huge2MB:
+            return size_t(1) << 21;
+        case PageSize::Huge1GB:
+            return size_t(1) << 30;
+        default:
+            return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        }
+    }
+
+    /**
+     * @brief Round a byte count up to whole pages
+     * @param bytes The number of bytes
+     * @return The mapping length
+     */
+    size_t RoundUpToPage(size_t bytes) const noexcept {
+        const auto page = PageBytes();
+        return (bytes + page - 1) & ~(page - 1);
+    }
+
+    /**
+     * @brief Map anonymous pages for bytes, preferring reserved huge pages, then transparent ones
+     * @param bytes The number of bytes
+     * @return The mapping, or nullptr on failure
+     */
+    void* MapPages(size_t bytes) const noexcept {
+        const auto page = PageBytes();
+        const auto length = RoundUpToPage(bytes);
+        const int protection = PROT_READ | PROT_WRITE;
+        const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+        void* memory = MAP_FAILED;
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+        if (pageSize_ != PageSize::Default) {
+            const int shift = pageSize_ == PageSize::Huge1GB ? 30 : 21;
+            memory = mmap(nullptr, length, protection, flags | MAP_HUGETLB | (shift << MAP_HUGE_SHIFT), -1, 0);
+        }
+#endif
+        if (memory == MAP_FAILED && pageSize_ != PageSize::Default) {
+            // No reserved huge pages, map a page-aligned region and ask for transparent huge pages
+            auto* raw = mmap(nullptr, length + page, protection, flags, -1, 0);
+            if (raw == MAP_FAILED) {
+                return nullptr;
+            }
+            const auto address = reinterpret_cast<uintptr_t>(raw);
+            const auto aligned = (address + page - 1) & ~(page - 1);
+            if (aligned != address) {
+                munmap(raw, aligned - address);
+            }
+            if (aligned + length != address + length + page) {
+                munmap(reinterpret_cast<void*>(aligned + length), address + page - aligned);
+            }
+            memory = reinterpret_cast<void*>(aligned);
+#if defined(MADV_HUGEPAGE)
+            madvise(memory, length, MADV_HUGEPAGE);
+#endif
+        } else if (memory == MAP_FAILED) {
+            memory = mmap(nullptr, length, protection, flags, -1, 0);
+            if (memory == MAP_FAILED) {
+                return nullptr;
+            }
+        }
+#if defined(SYS_mbind)
+        if (numaNode_ >= 0 && numaNode_ < 1024) {
+            // Bind before first touch so every page is faulted in on the chosen node
+            unsigned long nodeMask[1024 / (8 * sizeof(unsigned long))] = {};
+            nodeMask[numaNode_ / (8 * sizeof(unsigned long))] |= 1UL << (numaNode_ % (8 * sizeof(unsigned long)));
+            syscall(SYS_mbind, memory, length, MPOL_BIND, nodeMask, sizeof(nodeMask) * 8, 0);
+        }
+#endif
+        return memory;
+    }
+#endif
+
+private:
+    AllocateFn allocate_ = nullptr; // User allocation function, nullptr for the built-in strategies
+    DeallocateFn deallocate_ = nullptr; // User deallocation function
+    void* context_ = nullptr; // Passed through to the user functions
+    bool mapped_ = false; // Whether to allocate whole pages with mmap
+    PageSize pageSize_ = PageSize::Default; // Page size backing the mapping
+    int numaNode_ = -1; // NUMA node to bind the mapping to, -1 for none
+};
+
+namespace ringbuffer_detail {
+
+/**
+ * @brief Inline slot array of a RingBuffer whose capacity is a compile-time constant
+ */
+template <typename T, size_t Capacity>
+class SlotStorage {
+protected:
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2.");
+
+    /**
+     * @brief Number of slots
+     * @return The slot count
+     */
+    static constexpr size_t SlotCount() noexcept { return Capacity; }
+
+    /**
+     * @brief Mask turning an index into a slot position
+     * @return The mask
+     */
+    static constexpr size_t Mask() noexcept { return Capacity - 1; }
+
+    /**
+     * @brief Raw storage of a slot
+     * @param index The slot position
+     * @return The slot
+     */
+    T* Slot(size_t index) noexcept { return reinterpret_cast<T*>(buffer_ + index * sizeof(T)); }
+
+private:
+    // Slots are packed back to back with a stride of sizeof(T), e.g. eight uint64_t per cache line
+    alignas(T) unsigned char buffer_[sizeof(T) * Capacity]; // Buffer data
+};
+
+/**
+ * @brief Slot array of a RingBuffer whose capacity is chosen at construction
+ */
+template <typename T>
+class SlotStorage<T, DynamicCapacity> {
+protected:
+    /**
+     * @brief Allocate the slot array
+     * @param slots The number of slots, a power of 2, or 0 if the requested capacity overflowed
+     * @param allocator The allocator providing the memory
+     * @throws std::length_error if the slot array would not fit in the address space
+     * @throws std::bad_alloc if the allocator fails
+     */
+    SlotStorage(size_t slots, SlotAllocator allocator) : slots_(nullptr), mask_(slots - 1), allocator_(allocator) {
+        if (slots == 0 || slots > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::length_error("RingBuffer capacity too large");
+        }
+        slots_ = static_cast<T*>(allocator_.Allocate(Bytes(), Alignment()));
+        if (slots_ == nullptr) {
+            throw std::bad_alloc();
+        }
+    }
+
+    SlotStorage(const SlotStorage&) = delete;
+    SlotStorage& operator=(const SlotStorage&) = delete;
+
+    ~SlotStorage() { allocator_.Deallocate(slots_, Bytes(), Alignment()); }
+
+    size_t SlotCount() const noexcept { return mask_ + 1; }
+    size_t Mask() const noexcept { return mask_; }
+    T* Slot(size_t index) noexcept { return slots_ + index; }
+
+private:
+    size_t Bytes() const noexcept { return SlotCount() * sizeof(T); }
+    static constexpr size_t Alignment() noexcept { return std::max<size_t>(alignof(T), CacheLineSize); }
+
+private:
+    T* slots_; // Buffer data
+    size_t mask_; // Slot count minus one
+    SlotAllocator allocator_; // Source of the slot array
+};
+
+/**
+ * @brief Write timestamps of the slots, kept only when residency tracing is enabled
+ */
+template <bool Enabled, size_t Capacity>
+struct TraceStamps {
+    void Allocate(size_t) noexcept {}
+};
+
+template <size_t Capacity>
+struct alignas(CacheLineSize) TraceStamps<true, Capacity> {
+    void Allocate(size_t) noexcept {}
+    uint64_t& operator[](size_t index) noexcept { return stamps_[index]; }
+
+private:
+    uint64_t stamps_[Capacity]; // Write timestamp of each slot
+};
+
+template <>
+struct alignas(CacheLineSize) TraceStamps<true, DynamicCapacity> {
+    /**
+     * @brief Allocate one timestamp per slot
+     * @param slots The number of slots
+     * @throws std::bad_alloc if the timestamps cannot be allocated
+     */
+    void Allocate(size_t slots) { stamps_.reset(new uint64_t[slots]); }
+    uint64_t& operator[](size_t index) noexcept { return stamps_[index]; }
+
+private:
+    std::unique_ptr<uint64_t[]> stamps_; // Write timestamp of each slot
+};
+
+/**
+ * @brief Round up to the next power of 2
+ * @param value The value, at least 1
+ * @return The smallest power of 2 not below value, 0 if that does not fit in size_t
+ */
+constexpr size_t RoundUpToPowerOf2(size_t value) noexcept {
+    constexpr size_t largest = (std::numeric_limits<size_t>::max() >> 1) + 1;
+    if (value > largest) {
+        return 0;
+    }
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+/**
+ * @brief Index of the lowest set bit
+ * @param value The value, not 0
+ * @return The number of trailing zero bits
+ */
+inline unsigned CountTrailingZeros(uint64_t value) noexcept {
+    assert(value != 0);
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(value));
+#endif
+}
+
+/**
+ * @brief Index of the highest set bit, counted from the top
+ * @param value The value, not 0
+ * @return The number of leading zero bits
+ */
+inline unsigned CountLeadingZeros(uint64_t value) noexcept {
+    assert(value != 0);
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return 63 - static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_clzll(value));
+#endif
+}
+
+/**
+ * @brief Copy the unaligned head so the destination is Alignment-aligned for the vector loop
+ * @param out The destination, advanced past the head
+ * @param in The source, advanced past the head
+ * @param bytes The remaining bytes, reduced by the head
+ */
+template <size_t Alignment>
+inline void CopyHead(unsigned char*& out, const unsigned char*& in, size_t& bytes) noexcept {
+    const auto head = std::min(bytes, (Alignment - reinterpret_cast<uintptr_t>(out) % Alignment) % Alignment);
+    std::memcpy(out, in, head);
+    out += head;
+    in += head;
+    bytes -= head;
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+/**
+ * @brief StreamCopy() kernel with 16-byte non-temporal stores, available on every x86-64 CPU
+ */
+inline void StreamCopySse2(void* dst, const void* src, size_t bytes) noexcept {
+    auto* out = static_cast<unsigned char*>(dst);
+    auto* in = static_cast<const unsigned char*>(src);
+    CopyHead<16>(out, in, bytes);
+    for (; bytes >= 16; bytes -= 16, out += 16, in += 16) {
+        _mm_stream_si128(reinterpret_cast<__m128i*>(out), _mm_loadu_si128(reinterpret_cast<const __m128i*>(in)));
+    }
+    std::memcpy(out, in, bytes);
+    // Non-temporal stores are weakly ordered, even against a later release store
+    _mm_sfence();
+}
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define RINGBUFFER_HAS_X86_COPY_KERNELS 1
+
+/**
+ * @brief StreamCopy() kernel with 32-byte non-temporal stores, a full cache line per iteration
+ */
+__attribute__((target("avx2"))) inline void StreamCopyAvx2(void* dst, const void* src, size_t bytes) noexcept {
+    auto* out = static_cast<unsigned char*>(dst);
+    auto* in = static_cast<const unsigned char*>(src);
+    CopyHead<32>(out, in, bytes);
+    for (; bytes >= 64; bytes -= 64, out += 64, in += 64) {
+        const auto low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+        const auto high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 32));
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(out), low);
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(out + 32), high);
+    }
+    std::memcpy(out, in, bytes);
+    _mm_sfence();
+}
+
+/**
+ * @brief StreamCopy() kernel with 64-byte non-temporal stores, each one filling a write-combining buffer
+ */
+__attribute__((target("avx512f"))) inline void StreamCopyAvx512(void* dst, const void* src, size_t bytes) noexcept {
+    auto* out = static_cast<unsigned char*>(dst);
+    auto* in = static_cast<const unsigned char*>(src);
+    CopyHead<64>(out, in, bytes);
+    for (; bytes >= 64; bytes -= 64, out += 64, in += 64) {
+        _mm512_stream_si512(reinterpret_cast<__m512i*>(out), _mm512_loadu_si512(in));
+    }
+    std::memcpy(out, in, bytes);
+    _mm_sfence();
+}
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON) && (defined(__GNUC__) || defined(__clang__))
+/**
+ * @brief StreamCopy() kernel with 32-byte non-temporal store pairs (stnp), NEON being part of every ARMv8-A core
+ * @note Unlike x86, the release store that publishes the slots also orders stnp, so no fence is needed
+ */
+inline void StreamCopyNeon(void* dst, const void* src, size_t bytes) noexcept {
+    auto* out = static_cast<unsigned char*>(dst);
+    auto* in = static_cast<const unsigned char*>(src);
+    CopyHead<16>(out, in, bytes);
+    for (; bytes >= 32; bytes -= 32, out += 32, in += 32) {
+        const auto low = vld1q_u8(in);
+        const auto high = vld1q_u8(in + 16);
+        asm volatile("stnp %q0, %q1, [%2]" : : "w"(low), "w"(high), "r"(out) : "memory");
+    }
+    std::memcpy(out, in, bytes);
+}
+#endif
+
+using StreamCopyFunction = void (*)(void*, const void*, size_t) noexcept;
+
+/**
+ * @brief Pick the widest StreamCopy() kernel the CPU running the process supports
+ * @return The kernel, plain memcpy where no kernel exists
+ */
+inline StreamCopyFunction SelectStreamCopy() noexcept {
+#if defined(RINGBUFFER_HAS_X86_COPY_KERNELS)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return StreamCopyAvx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return StreamCopyAvx2;
+    }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+    return StreamCopySse2;
+#elif defined(__aarch64__) && defined(__ARM_NEON) && (defined(__GNUC__) || defined(__clang__))
+    return StreamCopyNeon;
+#else
+    return [](void* dst, const void* src, size_t bytes) noexcept { std::memcpy(dst, src, bytes); };
+#endif
+}
+
+/**
+ * @brief memcpy with non-temporal stores that bypass the cache, for large batches the consumer reads much later
+ * @param dst The destination
+ * @param src The source
+ * @param bytes The number of bytes
+ * @note Dispatches once per process on the CPU features: AVX-512, AVX2 or SSE2 on x86-64, NEON on AArch64.
+ *       Ends with whatever fence the target needs, so a following release store publishes the copied bytes
+ */
+inline void StreamCopy(void* dst, const void* src, size_t bytes) noexcept {
+    static const auto copy = SelectStreamCopy();
+    copy(dst, src, bytes);
+}
+
+/**
+ * @brief Size of the per-core L2 cache
+ * @return The size in bytes, 1 MiB when the system does not report it
+ */
+inline size_t L2CacheSize() noexcept {
+    static const size_t size = [] {
+#if defined(_SC_LEVEL2_CACHE_SIZE)
+        const auto reported = sysconf(_SC_LEVEL2_CACHE_SIZE);
+        if (reported > 0) {
+            return static_cast<size_t>(reported);
+        }
+#endif
+        return size_t(1) << 20;
+    }();
+    return size;
+}
+
+/**
+ * @brief Ask the CPU to bring every cache line of an object into the cache ahead of use
+ * @param address The object
+ * @param bytes The size of the object
+ * @note ForWrite requests the lines in exclusive state (prefetchw where the target has it),
+ *       saving the ownership request when the object is overwritten afterwards
+ */
+template <bool ForWrite>
+inline void Prefetch(const void* address, size_t bytes) noexcept {
+    const auto* line = static_cast<const char*>(address);
+    for (const auto* end = line + bytes; line < end; line += CacheLineSize) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_prefetch(line, _MM_HINT_T0);
+#elif defined(__GNUC__)
+        __builtin_prefetch(line, ForWrite ? 1 : 0, 3);
+#endif
+    }
+}
+
+} // namespace ringbuffer_detail
+
+#ifdef RINGBUFFER_HAS_COROUTINES
+/**
+ * @brief Executor resuming a coroutine right away on the thread that made it ready
+ */
+struct InlineExecutor {
+    void operator()(std::coroutine_handle<> handle) const { handle.resume(); }
+};
+
+namespace ringbuffer_detail {
+
+/**
+ * @brief AsyncWaiter suspending a coroutine, the common part of the RingBuffer awaitables
+ *
+ * A Notify() may claim the waiter while ParkAsync() is still re-checking the condition on the
+ * awaiting thread. The state word makes whichever of the two finishes second resume the
+ * coroutine, so it never runs while await_suspend() is still touching the awaiter.
+ */
+template <typename Executor>
+class CoroutineWaiter : private AsyncWaiter {
+protected:
+    explicit CoroutineWaiter(Executor executor) noexcept
+        : AsyncWaiter{&Wake}, executor_(std::move(executor)), state_(Registering) {}
+
+    /**
+     * @brief Park the coroutine on lot unless condition holds after registering
+     * @param handle The awaiting coroutine
+     * @param lot The parking lot notified when condition may hold
+     * @param condition Readiness check, must not consume anything
+     * @return Whether the coroutine stays suspended, the value await_suspend() should return
+     */
+    template <typename Condition>
+    bool Suspend(std::coroutine_handle<> handle, ParkingLot& lot, Condition&& condition) noexcept {
+        handle_ = handle;
+        state_.store(Registering, std::memory_order_relaxed);
+        if (lot.ParkAsync(condition, this)) {
+            return false;
+        }
+        return state_.exchange(Suspended, std::memory_order_acq_rel) != Woken;
+    }
+
+private:
+    static void Wake(AsyncWaiter* waiter) noexcept {
+        auto* self = static_cast<CoroutineWaiter*>(waiter);
+        if (self->state_.exchange(Woken, std::memory_order_acq_rel) == Suspended) {
+            self->executor_(self->handle_);
+        }
+    }
+
+private:
+    enum State : uint32_t {
+        Registering, // await_suspend() is still running
+        Suspended, // The coroutine is suspended, Wake() resumes it
+        Woken, // Wake() ran first, await_suspend() lets the coroutine continue
+    };
+
+    Executor executor_; // Resumes the coroutine
+    std::coroutine_handle<> handle_; // The suspended coroutine
+    std::atomic<uint32_t> state_; // Who resumes the coroutine
+};
+
+} // namespace ringbuffer_detail
+#endif
+
+/**
+ * @brief Wait strategy that spins with a pause instruction, lowest latency at the cost of a whole core
+ */
+struct BusySpinWait {
+    static constexpr bool Parks = false; // Never parks, so it works with Traits::Parking off
+
+    /**
+     * @brief Retry op until it succeeds
+     * @param op The non-blocking operation to retry
+     */
+    template <typename Op>
+    static void Until(Op&& op, ringbuffer_detail::ParkingLot&) noexcept {
+        while (!op()) {
+            ringbuffer_detail::CpuRelax();
+        }
+    }
+};
+
+/**
+ * @brief Wait strategy that spins with exponentially more pause instructions, then yields the CPU
+ */
+struct SpinThenYieldWait {
+    static constexpr bool Parks = false; // Never parks, so it works with Traits::Parking off
+    static constexpr unsigned MaxPauses = 64; // Longest run of pause instructions between two attempts
+    static constexpr unsigned SpinRounds = 16; // Attempts before yielding on every further one
+
+    /**
+     * @brief Retry op until it succeeds
+     * @param op The non-blocking operation to retry
+     */
+    template <typename Op>
+    static void Until(Op&& op, ringbuffer_detail::ParkingLot&) noexcept {
+        unsigned pauses = 1;
+        for (unsigned round = 0; !op(); ++round) {
+            if (round < SpinRounds) {
+                for (unsigned i = 0; i < pauses; ++i) {
+                    ringbuffer_detail::CpuRelax();
+                }
+                pauses = std::min(pauses * 2, MaxPauses);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+};
+
+/**
+ * @brief Wait strategy that spins briefly, then parks the thread until the other side publishes
+ */
+struct BlockingWait {
+    static constexpr bool Parks = true; // Needs Traits::Parking
+
+    /**
+     * @brief Retry op until it succeeds
+     * @param op The non-blocking operation to retry
+     * @param lot The parking lot notified when op may succeed
+     */
+    template <typename Op>
+    static void Until(Op&& op, ringbuffer_detail::ParkingLot& lot) noexcept {
+        ringbuffer_detail::BlockUntil(op, lot, static_cast<const std::chrono::steady_clock::time_point*>(nullptr));
+    }
+};
+
+namespace ringbuffer_detail {
+
+/**
+ * @brief Whether a wait strategy may park, assumed for a custom strategy without a Parks member
+ */
+template <typename WaitStrategy, typename = void>
+struct WaitStrategyParks : std::true_type {};
+
+template <typename WaitStrategy>
+struct WaitStrategyParks<WaitStrategy, std::void_t<decltype(WaitStrategy::Parks)>>
+    : std::bool_constant<WaitStrategy::Parks> {};
+
+} // namespace ringbuffer_detail
+
+/**
+ * @brief Counters collected by a RingBuffer statistics policy
+ */
+struct RingBufferStatsSnapshot {
+    uint64_t writes = 0; // Elements written
+    uint64_t fullRejections = 0; // Write attempts that found the RingBuffer full
+    uint64_t reads = 0; // Elements read
+    uint64_t emptyPolls = 0; // Read attempts that found the RingBuffer empty
+    uint64_t maxOccupancy = 0; // Highest occupancy seen whenever a side refreshed its cached index
+};
+
+/**
+ * @brief Statistics policy that collects nothing, every hook compiles away
+ */
+struct RingBufferNullStats {
+    struct Producer {
+        void OnWrite(size_t) noexcept {}
+        void OnFull() noexcept {}
+        void OnOccupancy(size_t) noexcept {}
+    };
+
+    struct Consumer {
+        void OnRead(size_t) noexcept {}
+        void OnEmpty() noexcept {}
+        void OnOccupancy(size_t) noexcept {}
+    };
+
+    static RingBufferStatsSnapshot Snapshot(const Producer&, const Consumer&) noexcept { return {}; }
+};
+
+/**
+ * @brief Statistics policy counting operations on each side's own cache line
+ *
+ * Each counter has a single writer, so it is bumped with a relaxed load and store rather than
+ * a read-modify-write, and a monitoring thread may read it at any time. Occupancy is sampled
+ * whenever a side reloads the other side's index, which is already off the fast path.
+ */
+struct RingBufferCountingStats {
+    class Producer {
+    public:
+        void OnWrite(size_t count) noexcept { Add(writes_, count); }
+        void OnFull() noexcept { Add(fullRejections_, 1); }
+        void OnOccupancy(size_t occupancy) noexcept { Max(maxOccupancy_, occupancy); }
+
+    private:
+        friend struct RingBufferCountingStats;
+        std::atomic<uint64_t> writes_{0}; // Elements written
+        std::atomic<uint64_t> fullRejections_{0}; // Write attempts that found the RingBuffer full
+        std::atomic<uint64_t> maxOccupancy_{0}; // Highest occupancy seen by the producer
+    };
+
+    class Consumer {
+    public:
+        void OnRead(size_t count) noexcept { Add(reads_, count); }
+        void OnEmpty() noexcept { Add(emptyPolls_, 1); }
+        void OnOccupancy(size_t occupancy) noexcept { Max(maxOccupancy_, occupancy); }
+
+    private:
+        friend struct RingBufferCountingStats;
+        std::atomic<uint64_t> reads_{0}; // Elements read
+        std::atomic<uint64_t> emptyPolls_{0}; // Read attempts that found the RingBuffer empty
+        std::atomic<uint64_t> maxOccupancy_{0}; // Highest occupancy seen by the consumer
+    };
+
+    static RingBufferStatsSnapshot Snapshot(const Producer& producer, const Consumer& consumer) noexcept {
+        RingBufferStatsSnapshot snapshot;
+        snapshot.writes = producer.writes_.load(std::memory_order_relaxed);
+        snapshot.fullRejections = producer.fullRejections_.load(std::memory_order_relaxed);
+        snapshot.reads = consumer.reads_.load(std::memory_order_relaxed);
+        snapshot.emptyPolls = consumer.emptyPolls_.load(std::memory_order_relaxed);
+        snapshot.maxOccupancy = std::max(producer.maxOccupancy_.load(std::memory_order_relaxed),
+                                         consumer.maxOccupancy_.load(std::memory_order_relaxed));
+        return snapshot;
+    }
+
+private:
+    static void Add(std::atomic<uint64_t>& counter, uint64_t value) noexcept {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    static void Max(std::atomic<uint64_t>& counter, uint64_t value) noexcept {
+        if (value > counter.load(std::memory_order_relaxed)) {
+            counter.store(value, std::memory_order_relaxed);
+        }
+    }
+};
+
+/**
+ * @brief Clock reading the CPU's cycle counter, the cheapest timestamp available
+ * @note Ticks are TSC cycles on x86 (constant rate on any CPU from the last decade) and
+ *       generic timer ticks on AArch64; elsewhere it falls back to steady_clock nanoseconds
+ */
+struct RingBufferTscClock {
+    static uint64_t Now() noexcept {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+        return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+        uint64_t ticks;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+        return ticks;
+#else
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+#endif
+    }
+};
+
+/**
+ * @brief Clock in steady_clock nanoseconds, slower to read than RingBufferTscClock but in known units
+ */
+struct RingBufferSteadyClock {
+    static uint64_t Now() noexcept {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+    }
+};
+
+/**
+ * @brief Log-linear latency histogram in the style of HdrHistogram
+ *
+ * Values below 2^SubBucketBits are counted exactly. Larger values fall into power-of-two ranges,
+ * each split into 2^(SubBucketBits - 1) linear sub-buckets, so every bucket is within
+ * 2^(1 - SubBucketBits) of the values it holds, e.g. ~6% for 5 bits and ~3% for 6.
+ */
+template <unsigned Bits>
+struct BasicRingBufferLatencyHistogram {
+    static_assert(Bits >= 1 && Bits < 64, "SubBucketBits must leave room for the power-of-two ranges.");
+
+    static constexpr unsigned SubBucketBits = Bits;
+    static constexpr uint64_t SubBuckets = uint64_t(1) << SubBucketBits;
+    static constexpr size_t BucketCount = SubBuckets + (64 - SubBucketBits) * (SubBuckets / 2);
+
+    uint64_t counts[BucketCount] = {}; // Values per bucket
+
+    /**
+     * @brief Count one value
+     * @param value The value, e.g. a latency in nanoseconds
+     */
+    void Record(uint64_t value) noexcept { ++counts[Index(value)]; }
+
+    /**
+     * @brief Number of recorded values
+     * @return The count
+     */
+    uint64_t Count() const noexcept {
+        uint64_t total = 0;
+        for (const auto count : counts) {
+            total += count;
+        }
+        return total;
+    }
+
+    /**
+     * @brief Value below which the given fraction of the recorded values fall
+     * @param quantile The fraction, e.g. 0.99
+     * @return The lowest value of the bucket holding the quantile, 0 if nothing was recorded
+     */
+    uint64_t Percentile(double quantile) const noexcept {
+        const auto total = Count();
+        if (total == 0) {
+            return 0;
+        }
+        // Clamped so a quantile of 1 lands on the bucket of the largest value
+        const auto target = std::min(static_cast<uint64_t>(quantile * static_cast<double>(total)), total - 1);
+        uint64_t seen = 0;
+        for (size_t index = 0; index < BucketCount; ++index) {
+            seen += counts[index];
+            if (seen > target) {
+                return LowestValue(index);
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Bucket counting a value
+     * @param value The value
+     * @return The bucket index
+     */
+    static size_t Index(uint64_t value) noexcept {
+        if (value < SubBuckets) {
+            return static_cast<size_t>(value);
+        }
+        const unsigned msb = 63 - ringbuffer_detail::CountLeadingZeros(value);
+        const unsigned shift = msb - SubBucketBits + 1;
+        const auto top = value >> shift; // In [SubBuckets / 2, SubBuckets)
+        return static_cast<size_t>(SubBuckets + (shift - 1) * (SubBuckets / 2) + (top - SubBuckets / 2));
+    }
+
+    /**
+     * @brief Lowest value a bucket counts
+     * @param index The bucket index
+     * @return The value
+     */
+    static uint64_t LowestValue(size_t index) noexcept {
+        if (index < SubBuckets) {
+            return index;
+        }
+        const auto shift = (index - SubBuckets) / (SubBuckets / 2) + 1;
+        const auto top = (index - SubBuckets) % (SubBuckets / 2) + SubBuckets / 2;
+        return static_cast<uint64_t>(top) << shift;
+    }
+};
+
+/**
+ * @brief Histogram of residency times in clock ticks, as returned by RingBuffer::ResidencySnapshot()
+ */
+using RingBufferLatencyHistogram = BasicRingBufferLatencyHistogram<5>;
+
+/**
+ * @brief Tracing policy that records nothing, no timestamp is taken or stored
+ */
+struct RingBufferNullTracing {
+    static constexpr bool Enabled = false;
+
+    struct Consumer {
+        void OnResidency(uint64_t) noexcept {}
+    };
+
+    static uint64_t Now() noexcept { return 0; }
+    static RingBufferLatencyHistogram Snapshot(const Consumer&) noexcept { return {}; }
+};
+
+/**
+ * @brief Tracing policy recording how long each element stays in the RingBuffer
+ *
+ * The producer stamps every slot with Clock::Now() when it publishes it, into an array parallel
+ * to the slots; the consumer takes one timestamp per published batch and adds each element's
+ * residency to a histogram on its own cache lines. A bucket has a single writer, so it is
+ * bumped with a relaxed load and store, and any thread may take a Snapshot().
+ */
+template <typename Clock = RingBufferTscClock>
+struct RingBufferResidencyTracing {
+    static constexpr bool Enabled = true;
+
+    class Consumer {
+    public:
+        void OnResidency(uint64_t ticks) noexcept {
+            auto& bucket = counts_[RingBufferLatencyHistogram::Index(ticks)];
+            bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+    private:
+        friend struct RingBufferResidencyTracing;
+        std::atomic<uint64_t> counts_[RingBufferLatencyHistogram::BucketCount] = {}; // Residencies per bucket
+    };
+
+    static uint64_t Now() noexcept { return Clock::Now(); }
+
+    static RingBufferLatencyHistogram Snapshot(const Consumer& consumer) noexcept {
+        RingBufferLatencyHistogram histogram;
+        for (size_t index = 0; index < RingBufferLatencyHistogram::BucketCount; ++index) {
+            histogram.counts[index] = consumer.counts_[index].load(std::memory_order_relaxed);
+        }
+        return histogram;
+    }
+};
+
+/**
+ * @brief Compile-time policies of a RingBuffer
+ *
+ * Derive from it and override members to customize a RingBuffer, e.g.
+ * struct CountedTraits : DefaultRingBufferTraits { using Stats = RingBufferCountingStats; };
+ * RingBuffer<Order, 1024, CountedTraits> orders;
+ */
+struct DefaultRingBufferTraits {
+    using Stats = RingBufferNullStats; // Statistics policy
+    using WaitStrategy = BlockingWait; // How ReadWait() and WriteWait() wait: BusySpinWait, SpinThenYieldWait or BlockingWait
+    static constexpr bool Parking = true; // Whether a thread may park: false drops the wake-up from every publish and rules out ReadBlocking(), WriteBlocking(), the Try*Until/For, coroutine and eventfd waits and a parking WaitStrategy
+    static constexpr size_t NonTemporalCopyThreshold = 0; // Bulk copies of trivially copyable T from this many bytes bypass the cache, 0 never, NonTemporalAboveL2 above the L2 size
+    static constexpr size_t PrefetchDistance = 0; // Slots ahead of the read index the consumer prefetches, 0 never
+    static constexpr bool PrefetchForWrite = false; // Whether the producer also prefetches the slot PrefetchDistance ahead for writing
+    using Tracing = RingBufferNullTracing; // Residency tracing policy: RingBufferNullTracing or RingBufferResidencyTracing<Clock>
+    static constexpr size_t LazyPublishCount = 0; // Publish the write index once this many elements are pending, or on Flush(); 0 or 1 on every write
+    static constexpr uint64_t LazyPublishMaxDelay = 0; // Nanoseconds after which the next write publishes everything pending, 0 no limit; checked only by writes, at one clock read per held-back write, so it bounds what Read() sees only under traffic; waiting reads take pending elements at once
+};
+
+/**
+ * @brief Up to two contiguous runs of slots inside a RingBuffer, the second one starts after the wrap-around
+ */
+template <typename T>
+struct RingBufferRange {
+    T* first = nullptr; // First contiguous run
+    size_t firstSize = 0; // Number of elements in the first run
+    T* second = nullptr; // Second contiguous run, starting at the beginning of the buffer
+    size_t secondSize = 0; // Number of elements in the second run
+
+    /**
+     * @brief Total number of elements in both runs
+     * @return The number of elements
+     */
+    size_t Size() const noexcept { return firstSize + secondSize; }
+};
+
+template <typename T, size_t Capacity, typename Traits = DefaultRingBufferTraits>
+class RingBuffer : private ringbuffer_detail::SlotStorage<T, Capacity> {
+    using Storage = ringbuffer_detail::SlotStorage<T, Capacity>;
+    using Storage::Mask;
+    using Storage::Slot;
+    using Storage::SlotCount;
+
+public:
+    static_assert(Capacity > 0, "Capacity must be greater than 0.");
+    static_assert(Traits::Parking || !ringbuffer_detail::WaitStrategyParks<typename Traits::WaitStrategy>::value,
+                  "A parking WaitStrategy needs Traits::Parking.");
+
+    template <size_t C = Capacity, std::enable_if_t<C != DynamicCapacity, int> = 0>
+    RingBuffer() noexcept {
+        if constexpr (Traits::Parking) {
+            ringbuffer_detail::InitAsymmetricBarrier();
+        }
+    }
+
+    /**
+     * @brief Construct a RingBuffer whose capacity is chosen at runtime, only for Capacity == DynamicCapacity
+     * @param capacity The minimum number of elements the RingBuffer must hold, rounded up to a power of 2
+     * @param allocator The allocator providing the slot array, e.g. SlotAllocator::Pages() for huge pages
+     * @throws std::length_error if the rounded capacity or its size in bytes does not fit in size_t
+     * @throws std::bad_alloc if the slot array cannot be allocated
+     */
+    template <size_t C = Capacity, std::enable_if_t<C == DynamicCapacity, int> = 0>
+    explicit RingBuffer(size_t capacity, SlotAllocator allocator = SlotAllocator::Heap())
+        : Storage(ringbuffer_detail::RoundUpToPowerOf2(capacity), allocator) {
+        producer_.stamps.Allocate(SlotCount());
+        if constexpr (Traits::Parking) {
+            ringbuffer_detail::InitAsymmetricBarrier();
+        }
+    }
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    ~RingBuffer() {
+        static_assert(alignof(RingBuffer) >= ringbuffer_detail::CacheLineSize &&
+                          sizeof(RingBuffer) % ringbuffer_detail::CacheLineSize == 0,
+                      "RingBuffer must not share a cache line with neighboring objects.");
+        static_assert(sizeof(ConsumerBlock) % ringbuffer_detail::CacheLineSize == 0 &&
+                          sizeof(ProducerBlock) % ringbuffer_detail::CacheLineSize == 0,
+                      "Producer and consumer state must occupy whole cache lines.");
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            const auto write = ProducerWriteIndex();
+            for (auto read = consumer_.readIndex.load(std::memory_order_relaxed); read != write; ++read) {
+                Slot(read & Mask())->~T();
+            }
+        }
+    }
+
+    /**
+     * @brief Maximum number of elements the RingBuffer can hold
+     * @return The capacity
+     */
+    size_t GetCapacity() const noexcept { return SlotCount(); }
+
+    /**
+     * @brief Number of elements currently in the RingBuffer
+     * @return The size, a snapshot that may be stale by the time it is used when called concurrently
+     */
+    size_t Size() const noexcept {
+        // Load the read index first so the difference never goes negative
+        const auto read = consumer_.readIndex.load(std::memory_order_acquire);
+        const auto write = producer_.writeIndex.load(std::memory_order_acquire);
+        if constexpr (LazyPublish()) {
+            // A waiting read may have taken elements not published yet
+            if (static_cast<std::ptrdiff_t>(write - read) < 0) {
+                return 0;
+            }
+        }
+        return std::min(write - read, SlotCount());
+    }
+
+    /**
+     * @brief Whether the RingBuffer currently holds no elements
+     * @return Whether it is empty, a snapshot like Size()
+     */
+    bool Empty() const noexcept { return Size() == 0; }
+
+    /**
+     * @brief Write data to the RingBuffer
+     * @param value The data to be written
+     * @return Whether the write operation is successful
+     */
+    bool Write(const T& value) noexcept { return Emplace(value); }
+
+    /**
+     * @brief Move data into the RingBuffer
+     * @param value The data to be written, left moved-from only if the write succeeds
+     * @return Whether the write operation is successful
+     */
+    bool Write(T&& value) noexcept { return Emplace(std::move(value)); }
+
+    /**
+     * @brief Construct an element in place at the end of the RingBuffer
+     * @param args The arguments forwarded to the constructor of T
+     * @return Whether the write operation is successful
+     * @note If the constructor throws, nothing is published
+     */
+    template <typename... Args>
+    bool Emplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args&&...>) {
+        const auto currentWrite = ProducerWriteIndex();
+        if (WritableSlots(currentWrite, 1) == 0) {
+            // RingBuffer is full
+            return false;
+        }
+        PrefetchWriteAhead(currentWrite);
+        if constexpr (IsCopyOfTrivial<Args...>()) {
+            std::memcpy(Slot(currentWrite & Mask()), std::addressof(args)..., sizeof(T));
+        } else {
+            new (Slot(currentWrite & Mask())) T(std::forward<Args>(args)...);
+        }
+        PublishWrite(currentWrite, 1);
+        return true;
+    }
+
+    /**
+     * @brief Read data from the RingBuffer
+     * @param value The read data
+     * @return Whether the read operation is successful
+     */
+    bool Read(T& value) noexcept {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            return Read([&](T&& element) { std::memcpy(std::addressof(value), std::addressof(element), sizeof(T)); });
+        } else {
+            return Read([&](T&& element) { value = std::move(element); });
+        }
+    }
+
+    /**
+     * @brief Read data from the RingBuffer into a new object move-constructed from the slot
+     * @return The read data, or std::nullopt if the RingBuffer is empty
+     */
+    std::optional<T> TryRead() noexcept(std::is_nothrow_move_constructible_v<T>) {
+        std::optional<T> value;
+        Read([&](T&& element) { value.emplace(std::move(element)); });
+        return value;
+    }
+
+    /**
+     * @brief Hand the oldest element to a callback, then remove it
+     * @param callback Invoked with the element as T&&, it may move from it or just inspect it
+     * @return Whether an element was read
+     * @note If the callback throws, the element stays in the RingBuffer
+     */
+    template <typename Callback, typename = std::enable_if_t<std::is_invocable_v<Callback&, T&&>>>
+    bool Read(Callback&& callback) noexcept(std::is_nothrow_invocable_v<Callback&, T&&>) {
+        const auto currentRead = consumer_.readIndex.load(std::memory_order_relaxed);
+        if (ReadableSlots(currentRead, 1) == 0) {
+            // RingBuffer is empty
+            return false;
+        }
+        PrefetchReadAhead(currentRead);
+        auto* slot = Slot(currentRead & Mask());
+        callback(std::move(*slot));
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            slot->~T();
+        }
+        PublishRead(currentRead, 1);
+        return true;
+    }
+
+    /**
+     * @brief Write data to the RingBuffer, waiting for a free slot if it is full
+     * @param value The data to be written
+     * @note Spins briefly, then parks the thread until the consumer frees a slot
+     */
+    void WriteBlocking(const T& value) noexcept {
+        static_assert(Traits::Parking, "Blocking waits need Traits::Parking.");
+        BlockingWait::Until([&] { return Write(value); }, writers_);
+    }
+
+    /**
+     * @brief Read data from the RingBuffer, waiting for data if it is empty
+     * @param value The read data
+     * @note Spins briefly, then parks the thread until the producer publishes data
+     */
+    void ReadBlocking(T& value) noexcept {
+        static_assert(Traits::Parking, "Blocking waits need Traits::Parking.");
+        BlockingWait::Until([&] { return WaitingRead(value); }, readers_);
+    }
+
+    /**
+     * @brief Write data to the RingBuffer, waiting for a free slot with Traits::WaitStrategy
+     * @param value The data to be written
+     */
+    void WriteWait(const T& value) noexcept {
+        Traits::WaitStrategy::Until([&] { return Write(value); }, writers_);
+    }
+
+    /**
+     * @brief Move data into the RingBuffer, waiting for a free slot with Traits::WaitStrategy
+     * @param value The data to be written
+     */
+    void WriteWait(T&& value) noexcept {
+        Traits::WaitStrategy::Until([&] { return Write(std::move(value)); }, writers_);
+    }
+
+    /**
+     * @brief Read data from the RingBuffer, waiting for data with Traits::WaitStrategy
+     * @param value The read data
+     */
+    void ReadWait(T& value) noexcept {
+        Traits::WaitStrategy::Until([&] { return WaitingRead(value); }, readers_);
+    }
+
+#ifdef RINGBUFFER_HAS_COROUTINES
+    /**
+     * @brief Awaitable returned by AsyncRead(), yields the read element
+     */
+    template <typename Executor>
+    class ReadAwaiter : private ringbuffer_detail::CoroutineWaiter<Executor> {
+    public:
+        ReadAwaiter(RingBuffer& buffer, Executor executor) noexcept
+            : ringbuffer_detail::CoroutineWaiter<Executor>(std::move(executor)), buffer_(buffer) {}
+
+        bool await_ready() noexcept { return TryRead(); }
+
+        bool await_suspend(std::coroutine_handle<> handle) noexcept {
+            return this->Suspend(handle, buffer_.readers_, [&] { return buffer_.ReadReady(); });
+        }
+
+        T await_resume() {
+            if (!value_) {
+                // Woken because an element was published, and this is the only consumer
+                [[maybe_unused]] const bool success = TryRead();
+                assert(success);
+            }
+            return std::move(*value_);
+        }
+
+    private:
+        bool TryRead() noexcept(std::is_nothrow_move_constructible_v<T>) {
+            return buffer_.Read([&](T&& element) { value_.emplace(std::move(element)); });
+        }
+
+    private:
+        RingBuffer& buffer_; // The RingBuffer read from
+        std::optional<T> value_; // The read element
+    };
+
+    /**
+     * @brief Awaitable returned by AsyncWrite()
+     */
+    template <typename Executor>
+    class WriteAwaiter : private ringbuffer_detail::CoroutineWaiter<Executor> {
+    public:
+        WriteAwaiter(RingBuffer& buffer, T value, Executor executor) noexcept(std::is_nothrow_move_constructible_v<T>)
+            : ringbuffer_detail::CoroutineWaiter<Executor>(std::move(executor)), buffer_(buffer),
+              value_(std::move(value)), written_(false) {}
+
+        bool await_ready() noexcept { return written_ = buffer_.Write(std::move(value_)); }
+
+        bool await_suspend(std::coroutine_handle<> handle) noexcept {
+            return this->Suspend(handle, buffer_.writers_, [&] { return buffer_.WriteReady(); });
+        }
+
+        void await_resume() noexcept {
+            if (!written_) {
+                // Woken because a slot was freed, and this is the only producer
+                [[maybe_unused]] const bool success = buffer_.Write(std::move(value_));
+                assert(success);
+            }
+        }
+
+    private:
+        RingBuffer& buffer_; // The RingBuffer written to
+        T value_; // The element to be written
+        bool written_; // Whether the fast path already wrote value_
+    };
+
+    /**
+     * @brief Read data from the RingBuffer in a coroutine, suspending while it is empty
+     * @param executor Called with the coroutine handle to resume it once data is published, on the producer's thread
+     * @return An awaitable yielding the read element
+     * @note co_await rb.AsyncRead() completes without suspending when data is available. Only the
+     *       single consumer may await, and with InlineExecutor it resumes inside the producer's publish
+     */
+    template <typename Executor = InlineExecutor>
+    ReadAwaiter<Executor> AsyncRead(Executor executor = Executor()) noexcept {
+        static_assert(Traits::Parking, "Blocking waits need Traits::Parking.");
+        return ReadAwaiter<Executor>(*this, std::move(executor));
+    }
+
+    /**
+     * @brief Write data to the RingBuffer in a coroutine, suspending while it is full
+     * @param value The data to be written
+     * @param executor Called with the coroutine handle to resume it once a slot is freed, on the consumer's thread
+     * @return An awaitable completing once the element is written
+     * @note Only the single producer may await, and with InlineExecutor it resumes inside the consumer's publish
+     */
+    template <typename Executor = InlineExecutor>
+    WriteAwaiter<Executor> AsyncWrite(T value, Executor executor = Executor()) {
+        static_assert(Traits::Parking, "Blocking waits need Traits::Parking.");
+        return WriteAwaiter<Executor>(*this, std::move(value), std::move(executor));
+    }
+#endif
+
+#if defined(__linux__)
+    /**
+     * @brief Create an eventfd that becomes readable when data arrives, to multiplex the RingBuffer with sockets
+     * @return The file descriptor, or -1 if it could not be created
+     * @note Register the fd with epoll or io_uring and call PrepareToPoll() before every wait on it. The
+     *       fd takes the consumer's asynchronous waiter, so it cannot be combined with AsyncRead()
+     */
+    int EnableNotificationFd() noexcept {
+        static_assert(Traits::Parking, "Blocking waits need Traits::Parking.");
+        if (notification_.fd < 0) {
+            notification_.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        }
+        return notification_.fd;
+    }
+
+    /**
+     * @brief The eventfd created by EnableNotificationFd()
+     * @return The file descriptor, or -1 if notifications are not enabled
+     */
+    int NotificationFd() const noexcept { return notification_.fd; }
+
+    /**
+     * @brief Arm the notification fd before waiting on it, must only be called by the consumer
+     * @return Whether the consumer may wait on the fd; false means data is already available
+     * @note The producer writes to the fd only for the first publish after the consumer armed it,
+     *       i.e. once per empty to non-empty transition, never per message
+     */
+    bool PrepareToPoll() noexcept {
+        assert(notification_.fd >= 0);
+        return notification_.Arm(readers_, [&] { return ReadReady(); });
+    }
+#endif
+
+    /**
+     * @brief Write data to the RingBuffer, waiting until the deadline for a free slot
+     * @param value The data to be written
+     * @param deadline The point in time after which to give up
+     * @return Whether the write operation is successful
+     */
+    template <typename Clock, typename Duration>
+    bool TryWriteUntil(const T& value, const std::chrono::time_point<Clock, Duration>& deadline) noexcept {
+        static_assert(Traits::Parking, "Blocking waits need Traits::Parking.");
+        return ringbuffer_detail::BlockUntil([&] { return Write(value); }, writers_, &deadline);
+    }
+
+    /**
+     * @brief Write data to the RingBuffer, waiting up to timeout for a free slot
+     * @param value The data to be written
+     * @param timeout The maximum time to wait
+     * @return Whether the write operation is successful
+     */
+    template <typename Rep, typename Period>
+    bool TryWriteFor(const T& value, const std::chrono::duration<Rep, Period>& timeout) noexcept {
+        return TryWriteUntil(value, std::chrono::steady_clock::now() + timeout);
+    }
+
+    /**
+     * @brief Read data from the RingBuffer, waiting until the deadline for data
+     * @param value The read data
+     * @param deadline The point in time after which to give up
+     * @return Whether the read operation is successful
+     */
+    template <typename Clock, typename Duration>
+    bool TryReadUntil(T& value, const std::chrono::time_point<Clock, Duration>& deadline) noexcept {
+        static_assert(Traits::Parking, "Blocking waits need Traits::Parking.");
+        return ringbuffer_detail::BlockUntil([&] { return WaitingRead(value); }, readers_, &deadline);
+    }
+
+    /**
+     * @brief Read data from the RingBuffer, waiting up to timeout for data
+     * @param value The read data
+     * @param timeout The maximum time to wait
+     * @return Whether the read operation is successful
+     */
+    template <typename Rep, typename Period>
+    bool TryReadFor(T& value, const std::chrono::duration<Rep, Period>& timeout) noexcept {
+        return TryReadUntil(value, std::chrono::steady_clock::now() + timeout);
+    }
+
+    /**
+     * @brief Write as many elements as fit into the RingBuffer, publishing the write index once
+     * @param src The elements to be written
+     * @param count The number of elements in src
+     * @return The number of elements actually written
+     */
+    size_t WriteBulk(const T* src, size_t count) noexcept {
+        const auto currentWrite = ProducerWriteIndex();
+        count = WritableSlots(currentWrite, count);
+        ForEachSegment(currentWrite, count, [&](size_t index, size_t offset, size_t length) {
+            CopyToSlots(index, src + offset, length);
+        });
+        PublishWrite(currentWrite, count);
+        return count;
+    }
+
+    /**
+     * @brief Write the elements of [first, last) that fit into the RingBuffer
+     * @param first The beginning of the range to be written
+     * @param last The end of the range to be written
+     * @return The number of elements actually written
+     */
+    template <typename ForwardIt, typename = std::enable_if_t<std::is_base_of_v<std::forward_iterator_tag,
+                  typename std::iterator_traits<ForwardIt>::iterator_category>>>
+    size_t WriteBulk(ForwardIt first, ForwardIt last) noexcept {
+        if constexpr (std::is_pointer_v<ForwardIt>) {
+            return WriteBulk(static_cast<const T*>(first), static_cast<size_t>(last - first));
+        } else {
+            const auto currentWrite = ProducerWriteIndex();
+            const auto count = WritableSlots(currentWrite, static_cast<size_t>(std::distance(first, last)));
+            ForEachSegment(currentWrite, count, [&](size_t index, size_t, size_t length) {
+                for (size_t i = 0; i < length; ++i, ++first) {
+                    new (Slot(index + i)) T(*first);
+                }
+            });
+            PublishWrite(currentWrite, count);
+            return count;
+        }
+    }
+
+    /**
+     * @brief Read up to count elements from the RingBuffer, publishing the read index once
+     * @param dst The destination for the read elements
+     * @param count The maximum number of elements to read
+     * @return The number of elements actually read
+     */
+    size_t ReadBulk(T* dst, size_t count) noexcept {
+        const auto currentRead = consumer_.readIndex.load(std::memory_order_relaxed);
+        count = ReadableSlots(currentRead, count);
+        ForEachSegment(currentRead, count, [&](size_t index, size_t offset, size_t length) {
+            MoveFromSlots(index, dst + offset, length);
+        });
+        PublishRead(currentRead, count);
+        return count;
+    }
+
+    /**
+     * @brief Read up to count elements from the RingBuffer into an output iterator
+     * @param dst The output iterator receiving the read elements
+     * @param count The maximum number of elements to read
+     * @return The number of elements actually read
+     */
+    template <typename OutputIt>
+    size_t ReadBulk(OutputIt dst, size_t count) noexcept {
+        const auto currentRead = consumer_.readIndex.load(std::memory_order_relaxed);
+        count = ReadableSlots(currentRead, count);
+        ForEachSegment(currentRead, count, [&](size_t index, size_t, size_t length) {
+            for (size_t i = 0; i < length; ++i, ++dst) {
+                auto* slot = Slot(index + i);
+                *dst = std::move(*slot);
+                if constexpr (!std::is_trivially_destructible_v<T>) {
+                    slot->~T();
+                }
+            }
+        });
+        PublishRead(currentRead, count);
+        return count;
+    }
+
+#ifdef __cpp_lib_span
+    /**
+     * @brief Write the elements of a span that fit into the RingBuffer
+     * @param src The elements to be written
+     * @return The number of elements actually written
+     */
+    size_t WriteBulk(std::span<const T> src) noexcept {
+        return WriteBulk(src.data(), src.size());
+    }
+
+    /**
+     * @brief Read up to dst.size() elements from the RingBuffer into a span
+     * @param dst The destination for the read elements
+     * @return The number of elements actually read
+     */
+    size_t ReadBulk(std::span<T> dst) noexcept {
+        return ReadBulk(dst.data(), dst.size());
+    }
+#endif
+
+    /**
+     * @brief Reserve one slot for in-place construction by the producer
+     * @return Raw storage of the reserved slot, or nullptr if the RingBuffer is full
+     * @note Construct the element with placement new, then call Commit() to publish it
+     */
+    T* TryReserve() noexcept {
+        const auto range = Reserve(1);
+        return range.first;
+    }
+
+    /**
+     * @brief Reserve up to count slots for in-place construction by the producer
+     * @param count The number of slots wanted
+     * @return The reserved raw storage, empty if the RingBuffer is full
+     * @note Construct the elements with placement new, then call Commit(n) to publish the first n of them
+     */
+    RingBufferRange<T> Reserve(size_t count) noexcept {
+        const auto currentWrite = ProducerWriteIndex();
+        return MakeRange<T>(currentWrite, WritableSlots(currentWrite, count));
+    }
+
+    /**
+     * @brief Publish elements constructed in slots obtained from TryReserve() or Reserve()
+     * @param count The number of constructed elements to publish
+     */
+    void Commit(size_t count = 1) noexcept {
+        const auto currentWrite = ProducerWriteIndex();
+        assert(count <= FreeSlots(currentWrite, producer_.cachedReadIndex));
+        PublishWrite(currentWrite, count);
+    }
+
+    /**
+     * @brief Access the oldest element in place without removing it
+     * @return The oldest element, or nullptr if the RingBuffer is empty
+     * @note Call Release() once the element is no longer needed
+     */
+    const T* Peek() noexcept {
+        const auto range = Peek(1);
+        return range.first;
+    }
+
+    /**
+     * @brief Access up to count of the oldest elements in place without removing them
+     * @param count The number of elements wanted
+     * @return The available elements, empty if the RingBuffer is empty
+     * @note Call Release(n) once the first n elements are no longer needed
+     */
+    RingBufferRange<const T> Peek(size_t count) noexcept {
+        const auto currentRead = consumer_.readIndex.load(std::memory_order_relaxed);
+        return MakeRange<const T>(currentRead, ReadableSlots(currentRead, count));
+    }
+
+    /**
+     * @brief Destroy and remove elements obtained from Peek()
+     * @param count The number of elements to release
+     */
+    void Release(size_t count = 1) noexcept {
+        const auto currentRead = consumer_.readIndex.load(std::memory_order_relaxed);
+        assert(count <= UsedSlots(consumer_.cachedWriteIndex, currentRead));
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            ForEachSegment(currentRead, count, [&](size_t index, size_t, size_t length) {
+                for (size_t i = 0; i < length; ++i) {
+                    Slot(index + i)->~T();
+                }
+            });
+        }
+        PublishRead(currentRead, count);
+    }
+
+    /**
+     * @brief Hand up to maxBatch elements to fn in place, then remove them with one index publish
+     * @param fn Called as fn(T&) for each element, oldest first, it may move from the element
+     * @param maxBatch The maximum number of elements to consume
+     * @return The number of elements consumed
+     * @note The write index is loaded at most once. If fn throws, the elements before the failing one
+     *       are removed and the failing one stays in the RingBuffer
+     */
+    template <typename F>
+    size_t Consume(F&& fn, size_t maxBatch = static_cast<size_t>(-1)) noexcept(std::is_nothrow_invocable_v<F&, T&>) {
+        // Publishes whatever was consumed, also when fn throws
+        struct PublishGuard {
+            RingBuffer* buffer;
+            size_t currentRead;
+            size_t consumed;
+
+            ~PublishGuard() { buffer->PublishRead(currentRead, consumed); }
+        };
+
+        const auto currentRead = consumer_.readIndex.load(std::memory_order_relaxed);
+        const auto count = ReadableSlots(currentRead, maxBatch);
+        PublishGuard guard{this, currentRead, 0};
+        ForEachSegment(currentRead, count, [&](size_t index, size_t, size_t length) {
+            auto* slots = Slot(index);
+            for (size_t i = 0; i < length; ++i) {
+                PrefetchReadAhead(currentRead + guard.consumed);
+                fn(slots[i]);
+                if constexpr (!std::is_trivially_destructible_v<T>) {
+                    slots[i].~T();
+                }
+                ++guard.consumed;
+            }
+        });
+        return count;
+    }
+
+    /**
+     * @brief Publish the elements held back by lazy publishing, producer side only
+     * @note Does nothing unless Traits::LazyPublishCount is above 1. Waiting reads (ReadWait(),
+     *       ReadBlocking(), TryReadUntil(), AsyncRead(), PrepareToPoll()) take pending elements
+     *       themselves, but Read(), Consume() and Peek() see them only once published. Traits::
+     *       LazyPublishMaxDelay is checked by the next write alone, so call Flush() whenever the
+     *       producer goes idle and the consumer polls
+     */
+    void Flush() noexcept {
+        if constexpr (LazyPublish()) {
+            const auto localWrite = producer_.localWriteIndex.load(std::memory_order_relaxed);
+            if (localWrite != producer_.writeIndex.load(std::memory_order_relaxed)) {
+                producer_.writeIndex.store(localWrite, std::memory_order_release);
+                WakeReaders();
+            }
+        }
+    }
+
+    /**
+     * @brief Read the statistics collected by Traits::Stats, safe to call from any thread
+     * @return The counters, all zero when statistics are compiled out
+     */
+    RingBufferStatsSnapshot Snapshot() const noexcept {
+        return Traits::Stats::Snapshot(producer_.stats, consumer_.stats);
+    }
+
+    /**
+     * @brief Read the residency histogram collected by Traits::Tracing, safe to call from any thread
+     * @return Time from publishing to consuming each element, in Tracing clock ticks; empty when tracing is compiled out
+     */
+    RingBufferLatencyHistogram ResidencySnapshot() const noexcept {
+        return Traits::Tracing::Snapshot(consumer_.tracing);
+    }
+
+private:
+    /**
+     * @brief Number of slots the producer can fill now, refreshing the cached read index only if needed
+     * @param currentWrite The write index
+     * @param wanted The number of slots wanted
+     * @return The number of slots the producer may fill, at most wanted
+     */
+    size_t WritableSlots(size_t currentWrite, size_t wanted) noexcept {
+        auto available = FreeSlots(currentWrite, producer_.cachedReadIndex);
+        if (available < wanted) {
+            // Looks too full from the cached copy, refresh it from the consumer. Acquire pairs with the
+            // release store in PublishRead(), so the consumer is done with the slots about to be reused
+            producer_.cachedReadIndex = consumer_.readIndex.load(std::memory_order_acquire);
+            available = FreeSlots(currentWrite, producer_.cachedReadIndex);
+            producer_.stats.OnOccupancy(SlotCount() - available);
+            if (available < wanted) {
+                // Never report full while holding back elements the consumer could be draining
+                Flush();
+            }
+            if (available == 0 && wanted != 0) {
+                producer_.stats.OnFull();
+            }
+        }
+        return std::min(available, wanted);
+    }
+
+    /**
+     * @brief Number of elements the consumer can take now, refreshing the cached write index only if needed
+     * @param currentRead The read index
+     * @param wanted The number of elements wanted
+     * @return The number of elements the consumer may take, at most wanted
+     */
+    size_t ReadableSlots(size_t currentRead, size_t wanted) noexcept {
+        auto available = UsedSlots(consumer_.cachedWriteIndex, currentRead);
+        if (available < wanted) {
+            // Looks too empty from the cached copy, refresh it from the producer
+            RefreshWriteIndex();
+            available = UsedSlots(consumer_.cachedWriteIndex, currentRead);
+            consumer_.stats.OnOccupancy(available);
+            if (available == 0 && wanted != 0) {
+                consumer_.stats.OnEmpty();
+            }
+        }
+        return std::min(available, wanted);
+    }
+
+    /**
+     * @brief Whether the producer could write now, the readiness check of a parked producer
+     * @return Whether a slot is free
+     * @note Unlike WritableSlots() it records no statistics and never flushes, so re-checking before
+     *       parking does not count as a failed write; only the producer's cached read index is refreshed
+     */
+    bool WriteReady() noexcept {
+        const auto currentWrite = ProducerWriteIndex();
+        if (FreeSlots(currentWrite, producer_.cachedReadIndex) != 0) {
+            return true;
+        }
+        producer_.cachedReadIndex = consumer_.readIndex.load(std::memory_order_acquire);
+        return FreeSlots(currentWrite, producer_.cachedReadIndex) != 0;
+    }
+
+    /**
+     * @brief Whether the consumer could read now, the readiness check of a parked consumer
+     * @return Whether an element is published, or held back by lazy publishing
+     * @note Unlike ReadableSlots() it records no statistics, so re-checking before parking does not
+     *       count as a failed read; only the consumer's cached write index is refreshed
+     */
+    bool ReadReady() noexcept {
+        const auto currentRead = consumer_.readIndex.load(std::memory_order_relaxed);
+        if (UsedSlots(consumer_.cachedWriteIndex, currentRead) != 0) {
+            return true;
+        }
+        RefreshWriteIndex();
+        return UsedSlots(consumer_.cachedWriteIndex, currentRead) != 0 || ClaimPending();
+    }
+
+    /**
+     * @brief Read data for a consumer that waits, also taking elements lazy publishing holds back
+     * @param value The read data
+     * @return Whether the read operation is successful
+     */
+    bool WaitingRead(T& value) noexcept { return Read(value) || (ClaimPending() && Read(value)); }
+
+    /**
+     * @brief Reload the cached write index from the published one
+     * @note Acquire pairs with the release store in PublishWrite(), making the elements below the index
+     *       visible. With lazy publishing the cached copy may be ahead after ClaimPending(), and then stays
+     */
+    void RefreshWriteIndex() noexcept {
+        const auto published = producer_.writeIndex.load(std::memory_order_acquire);
+        if constexpr (LazyPublish()) {
+            if (static_cast<std::ptrdiff_t>(published - consumer_.cachedWriteIndex) <= 0) {
+                return;
+            }
+        }
+        consumer_.cachedWriteIndex = published;
+    }
+
+    /**
+     * @brief Take the elements lazy publishing holds back into the consumer's cached write index
+     * @return Whether any were pending
+     * @note Only waiting reads call it: the load pulls in the producer's private line, which a polling
+     *       consumer must leave alone for lazy publishing to save anything. A waiting consumer wants the
+     *       data now, and the store-load pairing with DeferPublish() covers one about to park
+     */
+    bool ClaimPending() noexcept {
+        if constexpr (LazyPublish()) {
+            // Acquire pairs with the release store of localWriteIndex in PublishWrite()
+            const auto pending = producer_.localWriteIndex.load(std::memory_order_acquire);
+            if (pending != consumer_.cachedWriteIndex) {
+                consumer_.cachedWriteIndex = pending;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Prefetch the slot Traits::PrefetchDistance ahead of the read index if it is known to be written
+     * @param currentRead The read index
+     * @note Bounded by the cached write index, so it never loads the producer's index nor touches
+     *       a line the producer is still filling
+     */
+    void PrefetchReadAhead(size_t currentRead) noexcept {
+        if constexpr (Traits::PrefetchDistance != 0) {
+            if (UsedSlots(consumer_.cachedWriteIndex, currentRead) > Traits::PrefetchDistance) {
+                ringbuffer_detail::Prefetch<false>(Slot((currentRead + Traits::PrefetchDistance) & Mask()), sizeof(T));
+            }
+        }
+    }
+
+    /**
+     * @brief Prefetch for writing the slot Traits::PrefetchDistance ahead of the write index if it is known to be free
+     * @param currentWrite The write index
+     * @note Bounded by the cached read index, so it never takes a line away from a consumer still reading it
+     */
+    void PrefetchWriteAhead(size_t currentWrite) noexcept {
+        if constexpr (Traits::PrefetchForWrite && Traits::PrefetchDistance != 0) {
+            if (FreeSlots(currentWrite, producer_.cachedReadIndex) > Traits::PrefetchDistance) {
+                ringbuffer_detail::Prefetch<true>(Slot((currentWrite + Traits::PrefetchDistance) & Mask()), sizeof(T));
+            }
+        }
+    }
+
+    /**
+     * @brief Publish written elements and wake a parked consumer, if any
+     * @param currentWrite The write index before the elements
+     * @param count The number of elements written
+     */
+    void PublishWrite(size_t currentWrite, size_t count) noexcept {
+        if (count == 0) {
+            return;
+        }
+        producer_.stats.OnWrite(count);
+        if constexpr (Traits::Tracing::Enabled) {
+            const auto now = Traits::Tracing::Now();
+            for (size_t i = 0; i < count; ++i) {
+                producer_.stamps[(currentWrite + i) & Mask()] = now;
+            }
+        }
+        if constexpr (LazyPublish()) {
+            // Release so a waiting consumer may take the elements before they are published
+            producer_.localWriteIndex.store(currentWrite + count, std::memory_order_release);
+            if (DeferPublish(currentWrite)) {
+                return;
+            }
+        }
+        // Release orders the element construction before the index, the only cross-thread ordering Write needs
+        producer_.writeIndex.store(currentWrite + count, std::memory_order_release);
+        WakeReaders();
+    }
+
+    /**
+     * @brief Wake a consumer parked waiting for data, compiled out without Traits::Parking
+     */
+    void WakeReaders() noexcept {
+        if constexpr (Traits::Parking) {
+            readers_.Notify();
+        }
+    }
+
+    /**
+     * @brief Wake a producer parked waiting for a free slot, compiled out without Traits::Parking
+     */
+    void WakeWriters() noexcept {
+        if constexpr (Traits::Parking) {
+            writers_.Notify();
+        }
+    }
+
+    /**
+     * @brief Whether lazy publishing is enabled by Traits::LazyPublishCount
+     * @return Whether writes may leave the write index unpublished
+     */
+    static constexpr bool LazyPublish() noexcept { return Traits::LazyPublishCount > 1; }
+
+    /**
+     * @brief Write index as the producer sees it, including elements lazy publishing holds back
+     * @return The index of the next slot to fill
+     */
+    size_t ProducerWriteIndex() const noexcept {
+        if constexpr (LazyPublish()) {
+            return producer_.localWriteIndex.load(std::memory_order_relaxed);
+        } else {
+            return producer_.writeIndex.load(std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Whether lazy publishing may keep the elements written so far pending
+     * @param currentWrite The write index before the latest elements
+     * @return False once Traits::LazyPublishCount elements are pending, the consumer is parked waiting
+     *         for data, or the oldest one has waited Traits::LazyPublishMaxDelay
+     */
+    bool DeferPublish(size_t currentWrite) noexcept {
+        const auto published = producer_.writeIndex.load(std::memory_order_relaxed);
+        if (producer_.localWriteIndex.load(std::memory_order_relaxed) - published >= Traits::LazyPublishCount) {
+            return false;
+        }
+        if constexpr (Traits::Parking) {
+            // A parked consumer would otherwise sleep until the batch fills up. Pairs with the heavy barrier
+            // of Park(): either the consumer's recheck in ClaimPending() sees localWriteIndex, or the waiter is seen here
+            if (readers_.HasWaiters()) {
+                return false;
+            }
+        }
+        if constexpr (Traits::LazyPublishMaxDelay != 0) {
+            const auto now = RingBufferSteadyClock::Now();
+            if (currentWrite == published) {
+                // The oldest pending element
+                producer_.pendingSince = now;
+                return true;
+            }
+            return now - producer_.pendingSince < Traits::LazyPublishMaxDelay;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Publish read elements and wake a parked producer, if any
+     * @param currentRead The read index before the elements
+     * @param count The number of elements read
+     */
+    void PublishRead(size_t currentRead, size_t count) noexcept {
+        if (count == 0) {
+            return;
+        }
+        consumer_.stats.OnRead(count);
+        if constexpr (Traits::Tracing::Enabled) {
+            // The stamps stay valid until the release store below hands the slots back
+            const auto now = Traits::Tracing::Now();
+            for (size_t i = 0; i < count; ++i) {
+                consumer_.tracing.OnResidency(now - producer_.stamps[(currentRead + i) & Mask()]);
+            }
+        }
+        // Release orders moving the elements out before the index, so the producer cannot overwrite them early
+        consumer_.readIndex.store(currentRead + count, std::memory_order_release);
+        WakeWriters();
+    }
+
+    /**
+     * @brief Number of slots the producer may fill
+     * @param write The write index
+     * @param read The read index
+     * @return The number of free slots
+     */
+    size_t FreeSlots(size_t write, size_t read) noexcept {
+        return SlotCount() - (write - read);
+    }
+
+    /**
+     * @brief Number of slots the consumer may drain
+     * @param write The write index
+     * @param read The read index
+     * @return The number of used slots
+     */
+    size_t UsedSlots(size_t write, size_t read) noexcept {
+        return write - read;
+    }
+
+    /**
+     * @brief Split count slots starting at index into at most two contiguous runs
+     * @param index The first, unmasked index
+     * @param count The number of slots
+     * @param fn Called as fn(slotIndex, offset, length) for each contiguous run
+     */
+    template <typename F>
+    void ForEachSegment(size_t index, size_t count, F&& fn) {
+        const auto position = index & Mask();
+        const auto first = std::min(count, SlotCount() - position);
+        if (first > 0) {
+            fn(position, 0, first);
+        }
+        if (count > first) {
+            fn(0, first, count - first);
+        }
+    }
+
+    /**
+     * @brief Describe count slots starting at index as at most two contiguous runs
+     * @param index The first, unmasked index
+     * @param count The number of slots
+     * @return The slots as a RingBufferRange
+     */
+    template <typename U>
+    RingBufferRange<U> MakeRange(size_t index, size_t count) noexcept {
+        RingBufferRange<U> range;
+        ForEachSegment(index, count, [&](size_t slot, size_t offset, size_t length) {
+            auto* data = Slot(slot);
+            if (offset == 0) {
+                range.first = data;
+                range.firstSize = length;
+            } else {
+                range.second = data;
+                range.secondSize = length;
+            }
+        });
+        return range;
+    }
+
+    /**
+     * @brief Whether Emplace(args...) merely copies a trivially copyable T, so the slot can be filled with memcpy
+     * @return Whether args is a single T
+     */
+    template <typename... Args>
+    static constexpr bool IsCopyOfTrivial() noexcept {
+        if constexpr (sizeof...(Args) == 1) {
+            return std::is_trivially_copyable_v<T> && (std::is_same_v<std::decay_t<Args>, T> && ...);
+        } else {
+            return false;
+        }
+    }
+
+    /**
+     * @brief Copy-construct a contiguous run of elements into raw slots
+     * @param index The first slot index
+     * @param src The source elements
+     * @param count The number of elements
+     */
+    void CopyToSlots(size_t index, const T* src, size_t count) noexcept {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            const auto bytes = count * sizeof(T);
+            if (UseStreamCopy(bytes)) {
+                ringbuffer_detail::StreamCopy(Slot(index), src, bytes);
+            } else {
+                std::memcpy(Slot(index), src, bytes);
+            }
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                new (Slot(index + i)) T(src[i]);
+            }
+        }
+    }
+
+    /**
+     * @brief Whether a bulk copy is large enough for Traits::NonTemporalCopyThreshold
+     * @param bytes The size of the copy
+     * @return Whether to copy with non-temporal stores
+     */
+    static bool UseStreamCopy(size_t bytes) noexcept {
+        if constexpr (Traits::NonTemporalCopyThreshold == 0) {
+            return false;
+        } else if constexpr (Traits::NonTemporalCopyThreshold == NonTemporalAboveL2) {
+            return bytes > ringbuffer_detail::L2CacheSize();
+        } else {
+            return bytes >= Traits::NonTemporalCopyThreshold;
+        }
+    }
+
+    /**
+     * @brief Move a contiguous run of elements out of the slots and destroy them
+     * @param index The first slot index
+     * @param dst The destination elements
+     * @param count The number of elements
+     */
+    void MoveFromSlots(size_t index, T* dst, size_t count) noexcept {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            const auto bytes = count * sizeof(T);
+            if (UseStreamCopy(bytes)) {
+                ringbuffer_detail::StreamCopy(dst, Slot(index), bytes);
+            } else {
+                std::memcpy(dst, Slot(index), bytes);
+            }
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                auto* slot = Slot(index + i);
+                dst[i] = std::move(*slot);
+                slot->~T();
+            }
+        }
+    }
+
+private:
+    // Indices run freely and are only masked when addressing a slot, so full is write - read == capacity.
+    //
+    // Memory ordering: each index has a single writer, which loads it relaxed. The other side only
+    // needs acquire when it refreshes its cached copy, pairing with the owner's release store, and
+    // no path uses seq_cst: on x86 every load and store stays a plain mov, on ARMv8 the cost is one
+    // ldar/stlr per refresh or publish, plus one stlr of localWriteIndex per write with lazy
+    // publishing. The store-load ordering needed before parking is provided by LightBarrier()/
+    // HeavyBarrier(); with membarrier available the publisher's half is a compiler-only fence and
+    // the full barrier is paid by the thread about to park.
+    //
+    // Layout, in units of CacheLineSize lines: the slots (inline or a pointer to them), then each
+    // side's block, then the parking lots. Within a block the index the other side polls sits on
+    // its own line, apart from the owner's cached copy of the opposite index and its statistics,
+    // so a refresh by one side never pulls in the other side's private state (only a waiting read
+    // claiming lazily published elements loads localWriteIndex). The class is
+    // aligned to and padded up to a whole line, keeping neighboring objects off these lines.
+    struct ConsumerBlock {
+        alignas(ringbuffer_detail::CacheLineSize) std::atomic<size_t> readIndex{0}; // Read index
+        alignas(ringbuffer_detail::CacheLineSize) size_t cachedWriteIndex = 0; // Consumer-local copy of writeIndex, or of localWriteIndex after ClaimPending()
+        typename Traits::Stats::Consumer stats; // Consumer-side statistics
+        typename Traits::Tracing::Consumer tracing; // Consumer-side residency histogram
+    };
+
+    struct ProducerBlock {
+        alignas(ringbuffer_detail::CacheLineSize) std::atomic<size_t> writeIndex{0}; // Write index
+        alignas(ringbuffer_detail::CacheLineSize) size_t cachedReadIndex = 0; // Producer-local copy of readIndex
+        std::atomic<size_t> localWriteIndex{0}; // Write index including unpublished elements, with lazy publishing only; loaded by waiting reads
+        uint64_t pendingSince = 0; // When the oldest unpublished element was written, with LazyPublishMaxDelay only
+        typename Traits::Stats::Producer stats; // Producer-side statistics
+        ringbuffer_detail::TraceStamps<Traits::Tracing::Enabled, Capacity> stamps; // Publish time of each slot, on lines of its own
+    };
+
+    ConsumerBlock consumer_; // Consumer-owned state
+    ProducerBlock producer_; // Producer-owned state
+    alignas(ringbuffer_detail::CacheLineSize) ringbuffer_detail::ParkingLot readers_; // Consumer parked waiting for data
+    ringbuffer_detail::ParkingLot writers_; // Producer parked waiting for a free slot
+#if defined(__linux__)
+    ringbuffer_detail::NotificationWaiter notification_; // eventfd signaled when data arrives, if enabled
+#endif
+};
+
+/**
+ * @brief Unbounded single-producer single-consumer queue made of chained fixed-size RingBuffer segments
+ *
+ * Write and Read go straight to the current segment, so the fast path is that of a bounded
+ * RingBuffer. When the producer's segment fills up it links a new one, taken from a pool of
+ * segments the consumer has finished with or allocated if the pool is empty. The consumer
+ * moves on once its segment is drained and another is linked behind it, handing the drained
+ * segment back through the pool, itself a RingBuffer running from consumer to producer. Memory
+ * therefore follows the actual backlog instead of the worst-case burst.
+ */
+template <typename T, size_t SegmentCapacity = 1024, size_t PoolCapacity = 4>
+class UnboundedRingBuffer {
+public:
+    /**
+     * @brief Construct an UnboundedRingBuffer with one segment
+     * @throws std::bad_alloc if the segment cannot be allocated
+     */
+    UnboundedRingBuffer() : head_(new Segment), tail_(head_) {}
+
+    UnboundedRingBuffer(const UnboundedRingBuffer&) = delete;
+    UnboundedRingBuffer& operator=(const UnboundedRingBuffer&) = delete;
+
+    ~UnboundedRingBuffer() {
+        for (auto* segment = head_; segment != nullptr;) {
+            auto* next = segment->next.load(std::memory_order_relaxed);
+            delete segment;
+            segment = next;
+        }
+        Segment* segment;
+        while (pool_.Read(segment)) {
+            delete segment;
+        }
+    }
+
+    /**
+     * @brief Write data to the UnboundedRingBuffer
+     * @param value The data to be written
+     * @return Whether the write operation is successful, false only if a new segment cannot be allocated
+     * @note Like Emplace(), lets an exception from the copy constructor propagate
+     */
+    bool Write(const T& value) noexcept(std::is_nothrow_copy_constructible_v<T>) { return Emplace(value); }
+
+    /**
+     * @brief Move data into the UnboundedRingBuffer
+     * @param value The data to be written
+     * @return Whether the write operation is successful, false only if a new segment cannot be allocated
+     * @note Like Emplace(), lets an exception from the move constructor propagate
+     */
+    bool Write(T&& value) noexcept(std::is_nothrow_move_constructible_v<T>) { return Emplace(std::move(value)); }
+
+    /**
+     * @brief Construct an element in place at the end of the UnboundedRingBuffer
+     * @param args The arguments forwarded to the constructor of T
+     * @return Whether the write operation is successful, false only if a new segment cannot be allocated
+     * @note If the constructor throws, nothing is published and a segment taken for the element is freed
+     */
+    template <typename... Args>
+    bool Emplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args&&...>) {
+        // A full segment leaves args untouched, so they can be forwarded again to the next one
+        if (tail_->ring.Emplace(std::forward<Args>(args)...)) {
+            return true;
+        }
+        Segment* pooled = nullptr;
+        // Owns the segment until it is linked. The pool is only written by the consumer, so a
+        // segment whose element threw is freed rather than handed back
+        std::unique_ptr<Segment> segment(pool_.Read(pooled) ? pooled : new (std::nothrow) Segment);
+        if (segment == nullptr) {
+            return false;
+        }
+        segment->ring.Emplace(std::forward<Args>(args)...);
+        // Release publishes the element and everything written to the old segment before it
+        tail_->next.store(segment.get(), std::memory_order_release);
+        tail_ = segment.release();
+        return true;
+    }
+
+    /**
+     * @brief Read data from the UnboundedRingBuffer
+     * @param value The read data
+     * @return Whether the read operation is successful
+     */
+    bool Read(T& value) noexcept {
+        for (;;) {
+            if (head_->ring.Read(value)) {
+                return true;
+            }
+            auto* next = head_->next.load(std::memory_order_acquire);
+            if (next == nullptr) {
+                // UnboundedRingBuffer is empty
+                return false;
+            }
+            // The producer filled this segment before linking the next one, drain what it wrote last
+            if (head_->ring.Read(value)) {
+                return true;
+            }
+            auto* drained = head_;
+            head_ = next;
+            drained->next.store(nullptr, std::memory_order_relaxed);
+            if (!pool_.Write(drained)) {
+                delete drained;
+            }
+        }
+    }
+
+private:
+    struct Segment {
+        RingBuffer<T, SegmentCapacity> ring; // Elements of this segment
+        std::atomic<Segment*> next{nullptr}; // Segment linked by the producer once this one is full
+    };
+
+private:
+    alignas(ringbuffer_detail::CacheLineSize) Segment* head_; // Segment being read, owned by the consumer
+    alignas(ringbuffer_detail::CacheLineSize) Segment* tail_; // Segment being written, owned by the producer
+    RingBuffer<Segment*, PoolCapacity> pool_; // Drained segments handed back from the consumer to the producer
+};
+
+/**
+ * @brief Many producers and consumers spread over one SPSC RingBuffer per shard
+ *
+ * Each producer claims a shard of its own through a ProducerToken, preferring the shard of the
+ * CPU it runs on, and then writes through the plain SPSC fast path. Consumers drain their home
+ * shard first and steal batches from the other shards when it is empty. A consumer takes a
+ * shard's consumer side with a try-lock and skips shards that look empty or busy, so the only
+ * read-modify-write per batch is that lock, never one per element.
+ */
+template <typename T, size_t ShardCapacity>
+class ShardedRingBuffer {
+    struct Shard;
+
+public:
+    /**
+     * @brief Exclusive right to write to one shard, released on destruction
+     */
+    class ProducerToken {
+    public:
+        ProducerToken() noexcept : shard_(nullptr) {}
+        ProducerToken(ProducerToken&& other) noexcept : shard_(std::exchange(other.shard_, nullptr)) {}
+
+        ProducerToken& operator=(ProducerToken&& other) noexcept {
+            if (this != &other) {
+                Reset();
+                shard_ = std::exchange(other.shard_, nullptr);
+            }
+            return *this;
+        }
+
+        ~ProducerToken() { Reset(); }
+
+        /**
+         * @brief Whether the token holds a shard
+         * @return False if every shard was already claimed
+         */
+        bool Valid() const noexcept { return shard_ != nullptr; }
+
+    private:
+        friend class ShardedRingBuffer;
+
+        explicit ProducerToken(Shard* shard) noexcept : shard_(shard) {}
+
+        void Reset() noexcept {
+            if (shard_ != nullptr) {
+                // Release hands the shard's producer side to the next owner
+                shard_->producerClaimed.store(false, std::memory_order_release);
+                shard_ = nullptr;
+            }
+        }
+
+    private:
+        Shard* shard_; // The claimed shard
+    };
+
+    /**
+     * @brief Create a ShardedRingBuffer
+     * @param shards The number of shards, typically the number of producer cores
+     * @throws std::bad_alloc if the shards cannot be allocated
+     */
+    explicit ShardedRingBuffer(size_t shards) : shards_(new Shard[shards]), shardCount_(shards), nextHint_(0) {
+        assert(shards > 0);
+    }
+
+    ShardedRingBuffer(const ShardedRingBuffer&) = delete;
+    ShardedRingBuffer& operator=(const ShardedRingBuffer&) = delete;
+
+    /**
+     * @brief Number of shards
+     * @return The shard count
+     */
+    size_t GetShardCount() const noexcept { return shardCount_; }
+
+    /**
+     * @brief Claim a shard for the calling producer, preferring the one of the CPU it runs on
+     * @return The token, invalid if every shard is already claimed
+     */
+    ProducerToken AcquireProducer() noexcept {
+        const auto hint = ShardHint();
+        for (size_t i = 0; i < shardCount_; ++i) {
+            auto& shard = shards_[(hint + i) % shardCount_];
+            bool expected = false;
+            // Acquire takes over the producer side from the previous owner
+            if (!shard.producerClaimed.load(std::memory_order_relaxed) &&
+                shard.producerClaimed.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                return ProducerToken(&shard);
+            }
+        }
+        return ProducerToken();
+    }
+
+    /**
+     * @brief Write data to the token's shard
+     * @param token A valid token of this ShardedRingBuffer
+     * @param value The data to be written
+     * @return Whether the write operation is successful, false when the shard is full
+     */
+    bool Write(const ProducerToken& token, const T& value) noexcept { return Emplace(token, value); }
+
+    /**
+     * @brief Move data into the token's shard
+     * @param token A valid token of this ShardedRingBuffer
+     * @param value The data to be written
+     * @return Whether the write operation is successful, false when the shard is full
+     */
+    bool Write(const ProducerToken& token, T&& value) noexcept { return Emplace(token, std::move(value)); }
+
+    /**
+     * @brief Construct an element in place in the token's shard
+     * @param token A valid token of this ShardedRingBuffer
+     * @param args The arguments forwarded to the constructor of T
+     * @return Whether the write operation is successful, false when the shard is full
+     */
+    template <typename... Args>
+    bool Emplace(const ProducerToken& token, Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args&&...>) {
+        assert(token.Valid());
+        return token.shard_->ring.Emplace(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Read one element, from the home shard if it has any, otherwise from another shard
+     * @param home The consumer's home shard, e.g. its consumer number
+     * @param value The read data
+     * @return Whether the read operation is successful
+     */
+    bool Read(size_t home, T& value) noexcept {
+        return Consume(home, [&](T& element) { value = std::move(element); }, 1) != 0;
+    }
+
+    /**
+     * @brief Hand a batch of elements to fn in place, from the home shard if it has any, otherwise stolen from another
+     * @param home The consumer's home shard, e.g. its consumer number
+     * @param fn Called as fn(T&) for each element
+     * @param maxBatch The maximum number of elements to consume
+     * @return The number of elements consumed, all from the same shard
+     */
+    template <typename F>
+    size_t Consume(size_t home, F&& fn, size_t maxBatch = ShardCapacity) noexcept(std::is_nothrow_invocable_v<F&, T&>) {
+        for (size_t i = 0; i < shardCount_; ++i) {
+            auto& shard = shards_[(home + i) % shardCount_];
+            if (shard.ring.Empty() || shard.consumerLocked.exchange(true, std::memory_order_acquire)) {
+                // Nothing to take, or another consumer is draining it
+                continue;
+            }
+            // Release hands the shard's consumer side to the next consumer, also when fn throws
+            struct Unlock {
+                std::atomic<bool>& locked;
+                ~Unlock() { locked.store(false, std::memory_order_release); }
+            } unlock{shard.consumerLocked};
+            const auto consumed = shard.ring.Consume(fn, maxBatch);
+            if (consumed != 0) {
+                return consumed;
+            }
+        }
+        return 0;
+    }
+
+private:
+    struct Shard {
+        RingBuffer<T, ShardCapacity> ring; // Elements written by the shard's producer
+        alignas(ringbuffer_detail::CacheLineSize) std::atomic<bool> producerClaimed{false}; // Held by a ProducerToken
+        alignas(ringbuffer_detail::CacheLineSize) std::atomic<bool> consumerLocked{false}; // Held by a draining consumer
+    };
+
+    /**
+     * @brief Shard to try first for a new producer
+     * @return The CPU the caller runs on where known, otherwise the next shard in turn
+     */
+    size_t ShardHint() noexcept {
+#if defined(__linux__)
+        const auto cpu = sched_getcpu();
+        if (cpu >= 0) {
+            return static_cast<size_t>(cpu);
+        }
+#endif
+        return nextHint_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+private:
+    std::unique_ptr<Shard[]> shards_; // One SPSC RingBuffer per producer
+    size_t shardCount_; // Number of shards
+    std::atomic<size_t> nextHint_; // Round-robin hint where the CPU is unknown
+};
+
+/**
+ * @brief Single producer single consumer queue of Lanes SPSC RingBuffer lanes drained by priority
+ *
+ * Lane 0 has the highest priority. The producer sets a lane's bit in a shared mask on every
+ * write and the consumer clears it when it finds the lane empty, so picking the next lane is
+ * one load of the mask rather than one index load per lane.
+ *
+ * The price is one atomic read-modify-write per write on a line the consumer reads on every
+ * Read(), i.e. a locked instruction plus a cache line transfer while the consumer keeps up, on top
+ * of the lane's own index publish. Setting the bit only when it looks clear would need a
+ * store-load fence between the lane publish and that check, no cheaper than the RMW itself.
+ */
+template <typename T, size_t LaneCapacity, size_t Lanes>
+class PriorityRingBuffer {
+    static_assert(Lanes >= 1 && Lanes <= 64, "The non-empty mask holds at most 64 lanes.");
+
+public:
+    PriorityRingBuffer() noexcept : nonEmpty_(0), cursor_(Lanes - 1), credit_(0) {
+        for (auto& weight : weights_) {
+            weight = 1;
+        }
+    }
+
+    PriorityRingBuffer(const PriorityRingBuffer&) = delete;
+    PriorityRingBuffer& operator=(const PriorityRingBuffer&) = delete;
+
+    /**
+     * @brief Write data to a lane
+     * @param lane The lane, 0 being the highest priority
+     * @param value The data to be written
+     * @return Whether the write operation is successful, false when the lane is full
+     */
+    bool Write(size_t lane, const T& value) noexcept { return Emplace(lane, value); }
+
+    /**
+     * @brief Move data into a lane
+     * @param lane The lane, 0 being the highest priority
+     * @param value The data to be written
+     * @return Whether the write operation is successful, false when the lane is full
+     */
+    bool Write(size_t lane, T&& value) noexcept { return Emplace(lane, std::move(value)); }
+
+    /**
+     * @brief Construct an element in place in a lane
+     * @param lane The lane, 0 being the highest priority
+     * @param args The arguments forwarded to the constructor of T
+     * @return Whether the write operation is successful, false when the lane is full
+     */
+    template <typename... Args>
+    bool Emplace(size_t lane, Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args&&...>) {
+        assert(lane < Lanes);
+        if (!lanes_[lane].Emplace(std::forward<Args>(args)...)) {
+            return false;
+        }
+        // Release makes the element visible to a consumer whose clearing of the bit reads this one.
+        // Unconditional: skipping it when a relaxed load shows the bit set races with the consumer's
+        // clear-then-recheck in ReadLane() (each side may miss the other's store), stranding the element
+        nonEmpty_.fetch_or(LaneBit(lane), std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Read from the highest priority lane that holds data
+     * @param value The read data
+     * @return Whether the read operation is successful
+     */
+    bool Read(T& value) noexcept {
+        for (auto mask = nonEmpty_.load(std::memory_order_acquire); mask != 0; mask &= mask - 1) {
+            if (ReadLane(ringbuffer_detail::CountTrailingZeros(mask), value)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Read with weighted round-robin: each lane in turn serves up to its weight before the next one
+     * @param value The read data
+     * @return Whether the read operation is successful
+     * @note Lanes without data are skipped and give up the rest of their turn
+     */
+    bool ReadWeighted(T& value) noexcept {
+        for (auto mask = nonEmpty_.load(std::memory_order_acquire); mask != 0; mask &= ~LaneBit(cursor_)) {
+            if (credit_ == 0 || (mask & LaneBit(cursor_)) == 0) {
+                cursor_ = NextLane(mask, credit_ == 0 ? cursor_ + 1 : cursor_);
+                credit_ = weights_[cursor_];
+            }
+            if (ReadLane(cursor_, value)) {
+                --credit_;
+                return true;
+            }
+            credit_ = 0;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Set how many elements a lane serves per turn in ReadWeighted()
+     * @param lane The lane
+     * @param weight The weight, at least 1; every lane starts at 1
+     * @note Consumer-side state, call it from the consumer thread
+     */
+    void SetWeight(size_t lane, size_t weight) noexcept {
+        assert(lane < Lanes && weight > 0);
+        weights_[lane] = weight;
+    }
+
+    /**
+     * @brief Access one lane, e.g. for its bulk or zero-copy consumer interface
+     * @param lane The lane
+     * @return The lane's RingBuffer
+     * @note Writing to it directly bypasses the non-empty mask, so only read through it
+     */
+    RingBuffer<T, LaneCapacity>& Lane(size_t lane) noexcept {
+        assert(lane < Lanes);
+        return lanes_[lane];
+    }
+
+private:
+    static constexpr uint64_t LaneBit(size_t lane) noexcept { return uint64_t(1) << lane; }
+
+    /**
+     * @brief First lane in mask at or after from, wrapping around
+     * @param mask The non-empty lanes, not 0
+     * @param from The lane to start at, may be Lanes
+     * @return The lane
+     */
+    static size_t NextLane(uint64_t mask, size_t from) noexcept {
+        const auto upper = from < Lanes ? mask & (~uint64_t(0) << from) : 0;
+        return ringbuffer_detail::CountTrailingZeros(upper != 0 ? upper : mask);
+    }
+
+    /**
+     * @brief Read from one lane, clearing its bit when it turns out to be empty
+     * @param lane The lane
+     * @param value The read data
+     * @return Whether the read operation is successful
+     */
+    bool ReadLane(size_t lane, T& value) noexcept {
+        if (lanes_[lane].Read(value)) {
+            return true;
+        }
+        // A write whose fetch_or precedes the clear is visible to the re-check below; one after it sets the bit again
+        nonEmpty_.fetch_and(~LaneBit(lane), std::memory_order_acq_rel);
+        if (lanes_[lane].Empty()) {
+            return false;
+        }
+        nonEmpty_.fetch_or(LaneBit(lane), std::memory_order_relaxed);
+        return lanes_[lane].Read(value);
+    }
+
+private:
+    RingBuffer<T, LaneCapacity> lanes_[Lanes]; // Lane 0 has the highest priority
+    alignas(ringbuffer_detail::CacheLineSize) std::atomic<uint64_t> nonEmpty_; // Bit i set while lane i may hold data
+    alignas(ringbuffer_detail::CacheLineSize) size_t cursor_; // Lane serving the current ReadWeighted() turn
+    size_t credit_; // Elements left in the current turn
+    size_t weights_[Lanes]; // Elements per turn of each lane
+};
+
+/**
+ * @brief Bounded lock-free multi-producer multi-consumer RingBuffer
+ *
+ * Each slot carries a sequence number telling producers and consumers whose turn it is, so any
+ * number of threads can Write and Read concurrently with one CAS on the shared position per
+ * operation. Write and Read have the same signatures as RingBuffer, so either can be plugged into
+ * code that takes the buffer type as a template parameter.
+ */
+template <typename T, size_t Capacity>
+class MPMCRingBuffer {
+public:
+    static_assert(Capacity > 1, "Capacity must be greater than 1.");
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2.");
+
+    MPMCRingBuffer() noexcept : writeIndex_(0), readIndex_(0) {
+        for (size_t i = 0; i < Capacity; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MPMCRingBuffer(const MPMCRingBuffer&) = delete;
+    MPMCRingBuffer& operator=(const MPMCRingBuffer&) = delete;
+
+    ~MPMCRingBuffer() {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            const auto write = writeIndex_.load(std::memory_order_relaxed);
+            for (auto read = readIndex_.load(std::memory_order_relaxed); read != write; ++read) {
+                slots_[read & (Capacity - 1)].Value()->~T();
+            }
+        }
+    }
+
+    /**
+     * @brief Write data to the RingBuffer, safe to call from any number of threads
+     * @param value The data to be written
+     * @return Whether the write operation is successful
+     */
+    bool Write(const T& value) noexcept { return Emplace(value); }
+
+    /**
+     * @brief Move data into the RingBuffer, safe to call from any number of threads
+     * @param value The data to be written, left moved-from only if the write succeeds
+     * @return Whether the write operation is successful
+     */
+    bool Write(T&& value) noexcept { return Emplace(std::move(value)); }
+
+    /**
+     * @brief Construct an element in place, safe to call from any number of threads
+     * @param args The arguments forwarded to the constructor of T
+     * @return Whether the write operation is successful
+     * @note T must be nothrow constructible from args, a claimed slot cannot be given back
+     */
+    template <typename... Args>
+    bool Emplace(Args&&... args) noexcept {
+        auto position = writeIndex_.load(std::memory_order_relaxed);
+        for (;;) {
+            auto& slot = slots_[position & (Capacity - 1)];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence - position);
+            if (diff == 0) {
+                // The slot is free for this position, try to claim it
+                if (writeIndex_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    new (slot.Value()) T(std::forward<Args>(args)...);
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // RingBuffer is full
+                return false;
+            } else {
+                // Another producer claimed this position first
+                position = writeIndex_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Read data from the RingBuffer, safe to call from any number of threads
+     * @param value The read data
+     * @return Whether the read operation is successful
+     */
+    bool Read(T& value) noexcept {
+        auto position = readIndex_.load(std::memory_order_relaxed);
+        for (;;) {
+            auto& slot = slots_[position & (Capacity - 1)];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+            if (diff == 0) {
+                // The slot holds the element for this position, try to claim it
+                if (readIndex_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    value = std::move(*slot.Value());
+                    slot.Value()->~T();
+                    slot.sequence.store(position + Capacity, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // RingBuffer is empty
+                return false;
+            } else {
+                // Another consumer claimed this position first
+                position = readIndex_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence; // Position this slot is ready for
+        std::aligned_storage_t<sizeof(T), alignof(T)> storage; // Element storage
+
+        T* Value() noexcept { return reinterpret_cast<T*>(&storage); }
+    };
+
+private:
+    Slot slots_[Capacity]; // Buffer data
+    alignas(ringbuffer_detail::CacheLineSize) std::atomic<size_t> writeIndex_; // Next position to be claimed by a producer
+    alignas(ringbuffer_detail::CacheLineSize) std::atomic<size_t> readIndex_; // Next position to be claimed by a consumer
+};
+
+/**
+ * @brief Bounded multi-producer single-consumer RingBuffer
+ *
+ * Producers claim a position with a CAS on the write index once its slot's sequence number shows
+ * it free, as in MPMCRingBuffer, so a full buffer makes Write fail instead of waiting for the
+ * consumer. The consumer owns the read index outright and its Read path is as cheap as the SPSC
+ * RingBuffer one: no atomic read-modify-write, only the slot it is about to read is touched.
+ */
+template <typename T, size_t Capacity>
+class MPSCRingBuffer {
+public:
+    static_assert(Capacity > 1, "Capacity must be greater than 1.");
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2.");
+
+    MPSCRingBuffer() noexcept : writeIndex_(0), readIndex_(0) {
+        for (size_t i = 0; i < Capacity; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MPSCRingBuffer(const MPSCRingBuffer&) = delete;
+    MPSCRingBuffer& operator=(const MPSCRingBuffer&) = delete;
+
+    ~MPSCRingBuffer() {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (auto read = readIndex_;; ++read) {
+                auto& slot = slots_[read & (Capacity - 1)];
+                if (slot.sequence.load(std::memory_order_relaxed) != read + 1) {
+                    break;
+                }
+                slot.Value()->~T();
+            }
+        }
+    }
+
+    /**
+     * @brief Write data to the RingBuffer, safe to call from any number of threads
+     * @param value The data to be written
+     * @return Whether the write operation is successful, false when the RingBuffer is full
+     * @note Never waits for the consumer, only retries while other producers claim positions first
+     */
+    bool Write(const T& value) noexcept { return Emplace(value); }
+
+    /**
+     * @brief Move data into the RingBuffer, safe to call from any number of threads
+     * @param value The data to be written, left moved-from only if the write succeeds
+     * @return Whether the write operation is successful
+     */
+    bool Write(T&& value) noexcept { return Emplace(std::move(value)); }
+
+    /**
+     * @brief Construct an element in place, safe to call from any number of threads
+     * @param args The arguments forwarded to the constructor of T
+     * @return Whether the write operation is successful
+     * @note T must be nothrow constructible from args, a claimed slot cannot be given back
+     */
+    template <typename... Args>
+    bool Emplace(Args&&... args) noexcept {
+        // A blind fetch_add would let producers claim past the consumer and then wait for it, so the
+        // position is only claimed once its slot is known to be free
+        auto position = writeIndex_.load(std::memory_order_relaxed);
+        for (;;) {
+            auto& slot = slots_[position & (Capacity - 1)];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence - position);
+            if (diff == 0) {
+                // The slot is free for this position, try to claim it
+                if (writeIndex_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    new (slot.Value()) T(std::forward<Args>(args)...);
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // RingBuffer is full
+                return false;
+            } else {
+                // Another producer claimed this position first
+                position = writeIndex_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Read data from the RingBuffer, must only be called from the single consumer thread
+     * @param value The read data
+     * @return Whether the read operation is successful
+     */
+    bool Read(T& value) noexcept {
+        auto& slot = slots_[readIndex_ & (Capacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != readIndex_ + 1) {
+            // RingBuffer is empty, or the next producer has not finished writing yet
+            return false;
+        }
+        value = std::move(*slot.Value());
+        slot.Value()->~T();
+        slot.sequence.store(readIndex_ + Capacity, std::memory_order_release);
+        ++readIndex_;
+        return true;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence; // Position this slot is ready for
+        std::aligned_storage_t<sizeof(T), alignof(T)> storage; // Element storage
+
+        T* Value() noexcept { return reinterpret_cast<T*>(&storage); }
+    };
+
+private:
+    Slot slots_[Capacity]; // Buffer data
+    alignas(ringbuffer_detail::CacheLineSize) std::atomic<size_t> writeIndex_; // Next position to be claimed by a producer
+    alignas(ringbuffer_detail::CacheLineSize) size_t readIndex_; // Next position to be read, owned by the consumer
+};
+
+namespace ringbuffer_detail {
+
+/**
+ * @brief Slot guarded by a seqlock, for rings whose producer may overwrite elements a consumer has not read
+ *
+ * The sequence encodes the position held by the slot and is odd while the producer writes it.
+ * The payload is copied as relaxed atomic words, which keeps racing reads of a slot being
+ * overwritten well defined.
+ */
+template <typename T>
+class SeqlockSlot {
+public:
+    static_assert(std::is_trivially_copyable_v<T>, "Seqlock slots require a trivially copyable type.");
+
+    enum class LoadResult {
+        Empty, // The position has not been written yet, or is being written
+        Loaded, // The element was copied out
+        Overwritten, // A later position has replaced the element
+    };
+
+    /**
+     * @brief Store the element of a position, must only be called from the single producer thread
+     * @param position The position written
+     * @param value The data to be written
+     */
+    void Store(size_t position, const T& value) noexcept {
+        uint64_t words[WordCount] = {};
+        std::memcpy(words, std::addressof(value), sizeof(T));
+        sequence_.store(2 * uint64_t(position) + 1, std::memory_order_relaxed);
+        // Keeps the odd sequence ahead of the payload for a reader that sees part of the new payload
+#if !defined(RINGBUFFER_TSAN)
+        std::atomic_thread_fence(std::memory_order_release);
+#endif
+        for (size_t i = 0; i < WordCount; ++i) {
+            words_[i].store(words[i], WordStoreOrder);
+        }
+        sequence_.store(2 * uint64_t(position) + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copy out the element of a position
+     * @param position The position read
+     * @param value The read data, valid only when Loaded is returned
+     * @return Whether the element was copied, not written yet or already overwritten
+     */
+    LoadResult Load(size_t position, T& value) const noexcept {
+        const auto expected = 2 * uint64_t(position) + 2;
+        const auto before = sequence_.load(std::memory_order_acquire);
+        if (before < expected) {
+            return LoadResult::Empty;
+        }
+        if (before == expected) {
+            uint64_t words[WordCount];
+            for (size_t i = 0; i < WordCount; ++i) {
+                words[i] = words_[i].load(WordLoadOrder);
+            }
+            // Keeps the payload loads ahead of the sequence recheck
+#if !defined(RINGBUFFER_TSAN)
+            std::atomic_thread_fence(std::memory_order_acquire);
+#endif
+            if (sequence_.load(std::memory_order_relaxed) == before) {
+                std::memcpy(std::addressof(value), words, sizeof(T));
+                return LoadResult::Loaded;
+            }
+        }
+        return LoadResult::Overwritten;
+    }
+
+private:
+    static constexpr size_t WordCount = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+#if defined(RINGBUFFER_TSAN)
+    // ThreadSanitizer ignores the fences, so each payload word carries the ordering itself
+    static constexpr auto WordStoreOrder = std::memory_order_release;
+    static constexpr auto WordLoadOrder = std::memory_order_acquire;
+#else
+    static constexpr auto WordStoreOrder = std::memory_order_relaxed;
+    static constexpr auto WordLoadOrder = std::memory_order_relaxed;
+#endif
+
+    std::atomic<uint64_t> sequence_{0}; // Odd while position (sequence - 1) / 2 is written, even once it is readable
+    std::atomic<uint64_t> words_[WordCount]; // Element payload
+};
+
+/**
+ * @brief Read the oldest element not yet overwritten from a ring of seqlock slots
+ * @param slots The Capacity slots of the ring
+ * @param writeIndex The producer's write index
+ * @param readIndex The consumer's read index, advanced past the read and lost elements
+ * @param value The read data
+ * @param lost The number of elements overwritten before the consumer got to them
+ * @return Whether the read operation is successful
+ */
+template <typename T, size_t Capacity>
+bool ReadLatest(const SeqlockSlot<T>* slots, const std::atomic<size_t>& writeIndex, size_t& readIndex, T& value,
+                size_t& lost) noexcept {
+    using LoadResult = typename SeqlockSlot<T>::LoadResult;
+    lost = 0;
+    for (;;) {
+        const auto result = slots[readIndex & (Capacity - 1)].Load(readIndex, value);
+        if (result == LoadResult::Loaded) {
+            ++readIndex;
+            return true;
+        }
+        if (result == LoadResult::Empty) {
+            // Ring is empty, or the producer is still writing this element
+            return false;
+        }
+        // Lapped by the producer, skip to the oldest element that has not been overwritten
+        const auto currentWrite = writeIndex.load(std::memory_order_acquire);
+        if (currentWrite - readIndex > Capacity) {
+            lost += currentWrite - Capacity - readIndex;
+            readIndex = currentWrite - Capacity;
+        } else {
+            // The producer is overwriting this slot right now
+            CpuRelax();
+        }
+    }
+}
+
+} // namespace ringbuffer_detail
+
+/**
+ * @brief Single-producer single-consumer RingBuffer that overwrites the oldest element when full
+ *
+ * Meant for telemetry and latest-value feeds where fresh data matters more than complete data.
+ * The producer never looks at the consumer, so Write is wait-free and never fails. Every slot
+ * is a seqlock whose sequence encodes the position it holds, so the consumer notices when it
+ * has been lapped, skips to the oldest element still in the buffer and reports how many
+ * elements it lost.
+ */
+template <typename T, size_t Capacity>
+class OverwriteRingBuffer {
+public:
+    static_assert(Capacity > 1, "Capacity must be greater than 1.");
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2.");
+    static_assert(std::is_trivially_copyable_v<T>, "OverwriteRingBuffer requires a trivially copyable type.");
+
+    OverwriteRingBuffer() noexcept : writeIndex_(0), readIndex_(0) {}
+
+    OverwriteRingBuffer(const OverwriteRingBuffer&) = delete;
+    OverwriteRingBuffer& operator=(const OverwriteRingBuffer&) = delete;
+
+    /**
+     * @brief Capacity of the OverwriteRingBuffer
+     * @return The number of elements kept before the oldest is overwritten
+     */
+    static constexpr size_t GetCapacity() noexcept { return Capacity; }
+
+    /**
+     * @brief Write data to the OverwriteRingBuffer, overwriting the oldest element when full
+     * @param value The data to be written
+     * @return Always true, the write never fails
+     */
+    bool Write(const T& value) noexcept {
+        const auto position = writeIndex_.load(std::memory_order_relaxed);
+        slots_[position & (Capacity - 1)].Store(position, value);
+        writeIndex_.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Read the oldest element still in the OverwriteRingBuffer
+     * @param value The read data
+     * @param lost The number of elements overwritten before the consumer got to them
+     * @return Whether the read operation is successful
+     */
+    bool Read(T& value, size_t& lost) noexcept {
+        return ringbuffer_detail::ReadLatest<T, Capacity>(slots_, writeIndex_, readIndex_, value, lost);
+    }
+
+    /**
+     * @brief Read the oldest element still in the OverwriteRingBuffer, ignoring lost elements
+     * @param value The read data
+     * @return Whether the read operation is successful
+     */
+    bool Read(T& value) noexcept {
+        size_t lost;
+        return Read(value, lost);
+    }
+
+private:
+    ringbuffer_detail::SeqlockSlot<T> slots_[Capacity]; // Buffer data
+    alignas(ringbuffer_detail::CacheLineSize) std::atomic<size_t> writeIndex_; // Next position to be written, owned by the producer
+    alignas(ringbuffer_detail::CacheLineSize) size_t readIndex_; // Next position to be read, owned by the consumer
+};
+
+/**
+ * @brief Single-producer ring that delivers every element to each of a fixed set of consumers
+ *
+ * The producer writes each element once, and every consumer walks the ring with its own read
+ * cursor on its own cache line, so fanning one feed out to N threads costs one write instead
+ * of N. By default the producer gates on the slowest cursor and Write fails while any consumer
+ * still needs the oldest slot. With Lossy the producer never waits: slots become seqlocks as
+ * in OverwriteRingBuffer and a lapped consumer skips ahead and reports what it lost.
+ */
+template <typename T, size_t Capacity, bool Lossy = false>
+class BroadcastRingBuffer {
+public:
+    static_assert(Capacity > 1, "Capacity must be greater than 1.");
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2.");
+    static_assert(!Lossy || std::is_trivially_copyable_v<T>, "Lossy BroadcastRingBuffer requires a trivially copyable type.");
+
+    /**
+     * @brief Create a BroadcastRingBuffer for a fixed number of consumers
+     * @param consumers The number of consumers, identified by 0 to consumers - 1
+     * @throw std::bad_alloc if the cursors cannot be allocated
+     */
+    explicit BroadcastRingBuffer(size_t consumers)
+        : cursors_(new Cursor[consumers]), consumerCount_(consumers), writeIndex_(0), cachedMinReadIndex_(0) {
+        assert(consumers > 0);
+    }
+
+    BroadcastRingBuffer(const BroadcastRingBuffer&) = delete;
+    BroadcastRingBuffer& operator=(const BroadcastRingBuffer&) = delete;
+
+    ~BroadcastRingBuffer() {
+        if constexpr (!Lossy && !std::is_trivially_destructible_v<T>) {
+            const auto currentWrite = writeIndex_.load(std::memory_order_relaxed);
+            for (auto position = currentWrite - std::min(currentWrite, Capacity); position != currentWrite; ++position) {
+                slots_[position & (Capacity - 1)].Value()->~T();
+            }
+        }
+    }
+
+    /**
+     * @brief Capacity of the BroadcastRingBuffer
+     * @return The number of elements it can hold
+     */
+    static constexpr size_t GetCapacity() noexcept { return Capacity; }
+
+    /**
+     * @brief Number of consumers the BroadcastRingBuffer was created for
+     * @return The consumer count
+     */
+    size_t GetConsumerCount() const noexcept { return consumerCount_; }
+
+    /**
+     * @brief Write data for every consumer, must only be called from the single producer thread
+     * @param value The data to be written
+     * @return Whether the write operation is successful, always true when Lossy
+     */
+    bool Write(const T& value) noexcept {
+        const auto currentWrite = writeIndex_.load(std::memory_order_relaxed);
+        if constexpr (Lossy) {
+            slots_[currentWrite & (Capacity - 1)].Store(currentWrite, value);
+        } else {
+            if (currentWrite - cachedMinReadIndex_ == Capacity) {
+                // Looks full from the cached copy, find the slowest consumer again
+                cachedMinReadIndex_ = MinReadIndex();
+                if (currentWrite - cachedMinReadIndex_ == Capacity) {
+                    // A consumer still needs the oldest slot
+                    return false;
+                }
+            }
+            auto* slot = slots_[currentWrite & (Capacity - 1)].Value();
+            if (currentWrite >= Capacity) {
+                // Every consumer has moved past the element this slot held
+                slot->~T();
+            }
+            new (slot) T(value);
+        }
+        writeIndex_.store(currentWrite + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Read the next element of one consumer, must only be called from that consumer's thread
+     * @param consumer The consumer, less than GetConsumerCount()
+     * @param value The read data
+     * @param lost The number of elements overwritten before the consumer got to them, always 0 unless Lossy
+     * @return Whether the read operation is successful
+     */
+    bool Read(size_t consumer, T& value, size_t& lost) noexcept {
+        assert(consumer < consumerCount_);
+        auto& cursor = cursors_[consumer];
+        auto currentRead = cursor.readIndex.load(std::memory_order_relaxed);
+        if constexpr (Lossy) {
+            const auto success = ringbuffer_detail::ReadLatest<T, Capacity>(slots_, writeIndex_, currentRead, value, lost);
+            cursor.readIndex.store(currentRead, std::memory_order_relaxed);
+            return success;
+        } else {
+            lost = 0;
+            if (currentRead == cursor.cachedWriteIndex) {
+                // Looks empty from the cached copy, refresh it from the producer
+                cursor.cachedWriteIndex = writeIndex_.load(std::memory_order_acquire);
+                if (currentRead == cursor.cachedWriteIndex) {
+                    // Nothing new for this consumer
+                    return false;
+                }
+            }
+            value = *slots_[currentRead & (Capacity - 1)].Value();
+            cursor.readIndex.store(currentRead + 1, std::memory_order_release);
+            return true;
+        }
+    }
+
+    /**
+     * @brief Read the next element of one consumer, ignoring lost elements
+     * @param consumer The consumer, less than GetConsumerCount()
+     * @param value The read data
+     * @return Whether the read operation is successful
+     */
+    bool Read(size_t consumer, T& value) noexcept {
+        size_t lost;
+        return Read(consumer, value, lost);
+    }
+
+private:
+    struct StorageSlot {
+        std::aligned_storage_t<sizeof(T), alignof(T)> storage; // Element storage
+
+        T* Value() noexcept { return reinterpret_cast<T*>(&storage); }
+    };
+
+    using Slot = std::conditional_t<Lossy, ringbuffer_detail::SeqlockSlot<T>, StorageSlot>;
+
+    struct alignas(ringbuffer_detail::CacheLineSize) Cursor {
+        std::atomic<size_t> readIndex{0}; // Next position this consumer reads
+        size_t cachedWriteIndex = 0; // Consumer-local copy of writeIndex_
+    };
+
+    /**
+     * @brief Read index of the slowest consumer
+     * @return The smallest read index
+     */
+    size_t MinReadIndex() const noexcept {
+        const auto currentWrite = writeIndex_.load(std::memory_order_relaxed);
+        size_t lag = 0;
+        for (size_t i = 0; i < consumerCount_; ++i) {
+            lag = std::max(lag, currentWrite - cursors_[i].readIndex.load(std::memory_order_acquire));
+        }
+        return currentWrite - lag;
+    }
+
+private:
+    Slot slots_[Capacity]; // Buffer data
+    std::unique_ptr<Cursor[]> cursors_; // Read cursors, one cache line per consumer
+    size_t consumerCount_; // Number of cursors
+    alignas(ringbuffer_detail::CacheLineSize) std::atomic<size_t> writeIndex_; // Next position to be written, owned by the producer
+    size_t cachedMinReadIndex_; // Producer-local copy of the slowest read index
+};
+
+/**
+ * @brief Single-producer single-consumer ring of variable-length byte records
+ *
+ * Each record is an 8-byte header holding its length followed by the payload, padded to a
+ * multiple of 8 bytes, so every payload is 8-byte aligned. A record never straddles the end
+ * of the buffer: when it does not fit in the remaining tail, a padding record fills the tail
+ * and the record starts over at the beginning. Records are at most MaxRecordSize bytes, which
+ * guarantees a record always fits once the consumer has caught up.
+ */
+template <size_t Capacity>
+class ByteRingBuffer {
+public:
+    static_assert(Capacity >= 64, "Capacity must be at least 64 bytes.");
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2.");
+
+    static constexpr size_t RecordAlignment = 8; // Alignment of every header and payload
+    static constexpr size_t MaxRecordSize = Capacity / 2 - RecordAlignment; // Largest payload accepted
+
+    /**
+     * @brief A record available to the consumer
+     */
+    struct Record {
+        const void* data = nullptr; // Payload, nullptr when there is no record
+        size_t size = 0; // Payload length in bytes
+    };
+
+    ByteRingBuffer() noexcept
+        : readIndex_(0), cachedWriteIndex_(0), pendingRelease_(0), writeIndex_(0), cachedReadIndex_(0),
+          reservedPadding_(0), reservedSize_(0) {}
+
+    /**
+     * @brief Reserve contiguous space for a record of size bytes
+     * @param size The payload length in bytes
+     * @return 8-byte aligned payload storage, or nullptr if the record does not fit right now
+     * @note Fill the payload, then call Commit() to publish it
+     */
+    void* Reserve(size_t size) noexcept {
+        if (size > MaxRecordSize) {
+            return nullptr;
+        }
+        const auto currentWrite = writeIndex_.load(std::memory_order_relaxed);
+        const auto position = currentWrite & (Capacity - 1);
+        const auto length = RecordLength(size);
+        // Pad out the tail when the record would straddle the end of the buffer
+        const auto padding = length > Capacity - position ? Capacity - position : 0;
+        if (currentWrite + padding + length - cachedReadIndex_ > Capacity) {
+            // Looks full from the cached copy, refresh it from the consumer
+            cachedReadIndex_ = readIndex_.load(std::memory_order_acquire);
+            if (currentWrite + padding + length - cachedReadIndex_ > Capacity) {
+                // ByteRingBuffer is full
+                return nullptr;
+            }
+        }
+        reservedPadding_ = padding;
+        reservedSize_ = size;
+        return buffer_ + ((position + padding) & (Capacity - 1)) + sizeof(RecordHeader);
+    }
+
+    /**
+     * @brief Publish the record reserved by the last Reserve()
+     * @param size The actual payload length, at most the reserved size
+     */
+    void Commit(size_t size) noexcept {
+        assert(size <= reservedSize_);
+        const auto currentWrite = writeIndex_.load(std::memory_order_relaxed);
+        auto position = currentWrite & (Capacity - 1);
+        if (reservedPadding_ != 0) {
+            StoreHeader(position, RecordHeader{static_cast<uint32_t>(reservedPadding_), PaddingFlag});
+            position = 0;
+        }
+        StoreHeader(position, RecordHeader{static_cast<uint32_t>(size), 0});
+        writeIndex_.store(currentWrite + reservedPadding_ + RecordLength(size), std::memory_order_release);
+        reservedPadding_ = 0;
+        reservedSize_ = 0;
+    }
+
+    /**
+     * @brief Copy a record into the ByteRingBuffer
+     * @param data The payload
+     * @param size The payload length in bytes
+     * @return Whether the write operation is successful
+     */
+    bool Write(const void* data, size_t size) noexcept {
+        auto* payload = Reserve(size);
+        if (payload == nullptr) {
+            return false;
+        }
+        std::memcpy(payload, data, size);
+        Commit(size);
+        return true;
+    }
+
+    /**
+     * @brief Access the oldest record in place without removing it
+     * @return The record, with data set to nullptr if the ByteRingBuffer is empty
+     * @note Call Release() once the record is no longer needed
+     */
+    Record Peek() noexcept {
+        const auto currentRead = readIndex_.load(std::memory_order_relaxed);
+        if (currentRead == cachedWriteIndex_) {
+            // Looks empty from the cached copy, refresh it from the producer, acquire pairs with Commit()
+            cachedWriteIndex_ = writeIndex_.load(std::memory_order_acquire);
+            if (currentRead == cachedWriteIndex_) {
+                // ByteRingBuffer is empty
+                return Record{};
+            }
+        }
+        size_t length = 0;
+        const auto record = LoadRecord(currentRead, length);
+        pendingRelease_ = length;
+        return record;
+    }
+
+    /**
+     * @brief Remove the record returned by the last Peek()
+     */
+    void Release() noexcept {
+        assert(pendingRelease_ != 0);
+        const auto currentRead = readIndex_.load(std::memory_order_relaxed);
+        readIndex_.store(currentRead + pendingRelease_, std::memory_order_release);
+        pendingRelease_ = 0;
+    }
+
+    /**
+     * @brief Hand up to maxRecords records to fn in place, then remove them with one index publish
+     * @param fn Called as fn(const void* data, size_t size) for each record
+     * @param maxRecords The maximum number of records to consume
+     * @return The number of records consumed
+     * @note If fn throws, the records before the failing one are removed and the failing one stays
+     */
+    template <typename F>
+    size_t Consume(F&& fn, size_t maxRecords = static_cast<size_t>(-1)) noexcept(
+        std::is_nothrow_invocable_v<F&, const void*, size_t>) {
+        // Publishes the records handed out so far, also when fn throws
+        struct PublishGuard {
+            ByteRingBuffer* buffer;
+            size_t currentRead;
+            size_t read;
+
+            ~PublishGuard() {
+                if (read != currentRead) {
+                    buffer->readIndex_.store(read, std::memory_order_release);
+                }
+            }
+        };
+
+        const auto currentRead = readIndex_.load(std::memory_order_relaxed);
+        if (currentRead == cachedWriteIndex_) {
+            // Acquire pairs with the release store in Commit()
+            cachedWriteIndex_ = writeIndex_.load(std::memory_order_acquire);
+        }
+        PublishGuard guard{this, currentRead, currentRead};
+        size_t consumed = 0;
+        while (guard.read != cachedWriteIndex_ && consumed < maxRecords) {
+            size_t length = 0;
+            const auto record = LoadRecord(guard.read, length);
+            fn(record.data, record.size);
+            guard.read += length;
+            ++consumed;
+        }
+        return consumed;
+    }
+
+private:
+    struct RecordHeader {
+        uint32_t size; // Payload length, or the whole padding length for padding records
+        uint32_t flags; // PaddingFlag for padding records
+    };
+    static_assert(sizeof(RecordHeader) == RecordAlignment, "Record header must be 8 bytes.");
+
+    static constexpr uint32_t PaddingFlag = 1; // The record only fills the tail of the buffer
+
+    /**
+     * @brief Bytes taken by a record: its header plus its payload rounded up to RecordAlignment
+     * @param size The payload length
+     * @return The record length
+     */
+    static constexpr size_t RecordLength(size_t size) noexcept {
+        return sizeof(RecordHeader) + ((size + RecordAlignment - 1) & ~(RecordAlignment - 1));
+    }
+
+    /**
+     * @brief Store a record header
+     * @param position The masked position of the header
+     * @param header The header
+     */
+    void StoreHeader(size_t position, const RecordHeader& header) noexcept {
+        std::memcpy(buffer_ + position, &header, sizeof(header));
+    }
+
+    /**
+     * @brief Load a record header
+     * @param position The masked position of the header
+     * @return The header
+     */
+    RecordHeader LoadHeader(size_t position) const noexcept {
+        RecordHeader header;
+        std::memcpy(&header, buffer_ + position, sizeof(header));
+        return header;
+    }
+
+    /**
+     * @brief Decode the record at index, skipping a padding record in front of it
+     * @param index The unmasked read index
+     * @param length Receives the bytes to advance past the record, padding included
+     * @return The record
+     */
+    Record LoadRecord(size_t index, size_t& length) const noexcept {
+        auto position = index & (Capacity - 1);
+        auto header = LoadHeader(position);
+        length = 0;
+        if (header.flags & PaddingFlag) {
+            // A padding record is always committed together with the record that follows it
+            length = Capacity - position;
+            position = 0;
+            header = LoadHeader(position);
+        }
+        length += RecordLength(header.size);
+        return Record{buffer_ + position + sizeof(RecordHeader), header.size};
+    }
+
+private:
+    alignas(ringbuffer_detail::CacheLineSize) unsigned char buffer_[Capacity]; // Buffer data
+    alignas(ringbuffer_detail::CacheLineSize) std::atomic<size_t> readIndex_; // Read index, in bytes
+    alignas(ringbuffer_detail::CacheLineSize) size_t cachedWriteIndex_; // Consumer-local copy of writeIndex_
+    size_t pendingRelease_; // Bytes the next Release() removes
+    alignas(ringbuffer_detail::CacheLineSize) std::atomic<size_t> writeIndex_; // Write index, in bytes
+    alignas(ringbuffer_detail::CacheLineSize) size_t cachedReadIndex_; // Producer-local copy of readIndex_
+    size_t reservedPadding_; // Tail padding in front of the reserved record
+    size_t reservedSize_; // Payload length of the reserved record
+};
+
+/**
+ * @brief Cross-process single-producer single-consumer RingBuffer living in shared memory
+ *
+ * The object is its own wire format: a header (magic, version, element size, capacity) at
+ * offset 0, the producer and consumer cache lines at fixed offsets after it, then the slots.
+ * It holds no pointers, so each process may map it at a different address. One process
+ * initializes the memory with Create(), the others validate it with Attach(). Only trivially
+ * copyable T is allowed since elements are copied between address spaces byte for byte.
+ * There is no blocking API, a process-local futex cannot wake another process.
+ */
 template <typename T, size_t Capacity>
-class RingBuffer {
+class SharedRingBuffer {
 public:
     static_assert(Capacity > 0, "Capacity must be greater than 0.");
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2.");
+    static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable to be shared between processes.");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared indices need lock-free 64-bit atomics.");
+
+    static constexpr uint64_t Magic = 0x5246554272474e52; // "RNGrBUFR"
+    static constexpr uint32_t Version = 1; // Bumped whenever the layout changes
+
+    SharedRingBuffer(const SharedRingBuffer&) = delete;
+    SharedRingBuffer& operator=(const SharedRingBuffer&) = delete;
+
+    /**
+     * @brief Number of bytes of shared memory the RingBuffer needs
+     * @return The size in bytes
+     */
+    static constexpr size_t RequiredBytes() noexcept { return sizeof(SharedRingBuffer); }
+
+    /**
+     * @brief Initialize an empty RingBuffer in shared memory, done by exactly one process
+     * @param memory The mapping, aligned to at least 64 bytes
+     * @param bytes The size of the mapping
+     * @return The RingBuffer, or nullptr if the mapping is too small or misaligned
+     */
+    static SharedRingBuffer* Create(void* memory, size_t bytes) noexcept {
+        static_assert(std::is_standard_layout_v<SharedRingBuffer>, "Shared layout must be standard layout.");
+        static_assert(offsetof(SharedRingBuffer, magic_) == 0, "Magic must come first.");
+        static_assert(offsetof(SharedRingBuffer, writeIndex_) == 64, "Producer line must start at offset 64.");
+        static_assert(offsetof(SharedRingBuffer, readIndex_) == 128, "Consumer line must start at offset 128.");
+        static_assert(offsetof(SharedRingBuffer, slots_) == 192, "Slots must start at offset 192.");
+        if (!Fits(memory, bytes)) {
+            return nullptr;
+        }
+        auto* buffer = new (memory) SharedRingBuffer();
+        // Publish the magic last, an attaching process only trusts the header once it sees it
+        buffer->magic_.store(Magic, std::memory_order_release);
+        return buffer;
+    }
 
-    RingBuffer() noexcept : readIndex_(0), writeIndex_(0) {}
+    /**
+     * @brief Attach to a RingBuffer another process initialized with Create()
+     * @param memory The mapping
+     * @param bytes The size of the mapping
+     * @return The RingBuffer, or nullptr if the memory holds no compatible RingBuffer
+     */
+    static SharedRingBuffer* Attach(void* memory, size_t bytes) noexcept {
+        if (!Fits(memory, bytes)) {
+            return nullptr;
+        }
+        auto* buffer = static_cast<SharedRingBuffer*>(memory);
+        if (buffer->magic_.load(std::memory_order_acquire) != Magic || buffer->version_ != Version ||
+            buffer->elementSize_ != sizeof(T) || buffer->capacity_ != Capacity) {
+            return nullptr;
+        }
+        return buffer;
+    }
 
     /**
      * @brief Write data to the RingBuffer
@@ -26,13 +3794,16 @@ public:
      */
     bool Write(const T& value) noexcept {
         const auto currentWrite = writeIndex_.load(std::memory_order_relaxed);
-        const auto nextWrite = IncrementIndex(currentWrite);
-        if (nextWrite == readIndex_.load(std::memory_order_acquire)) {
-            // RingBuffer is full
-            return false;
+        if (currentWrite - cachedReadIndex_ == Capacity) {
+            // Looks full from the cached copy, refresh it from the consumer
+            cachedReadIndex_ = readIndex_.load(std::memory_order_acquire);
+            if (currentWrite - cachedReadIndex_ == Capacity) {
+                // RingBuffer is full
+                return false;
+            }
         }
-        new (&buffer_[currentWrite]) T(value);
-        writeIndex_.store(nextWrite, std::memory_order_release);
+        std::memcpy(std::addressof(slots_[currentWrite & (Capacity - 1)]), std::addressof(value), sizeof(T));
+        writeIndex_.store(currentWrite + 1, std::memory_order_release);
         return true;
     }
 
@@ -43,32 +3814,510 @@ public:
      */
     bool Read(T& value) noexcept {
         const auto currentRead = readIndex_.load(std::memory_order_relaxed);
-        if (currentRead == writeIndex_.load(std::memory_order_consume)) {
-            // RingBuffer is empty
+        if (currentRead == cachedWriteIndex_) {
+            // Looks empty from the cached copy, refresh it from the producer, acquire pairs with Write()
+            cachedWriteIndex_ = writeIndex_.load(std::memory_order_acquire);
+            if (currentRead == cachedWriteIndex_) {
+                // RingBuffer is empty
+                return false;
+            }
+        }
+        std::memcpy(std::addressof(value), std::addressof(slots_[currentRead & (Capacity - 1)]), sizeof(T));
+        readIndex_.store(currentRead + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Number of elements currently in the RingBuffer
+     * @return The size, a snapshot that may be stale by the time it is used
+     */
+    size_t Size() const noexcept {
+        const auto read = readIndex_.load(std::memory_order_acquire);
+        const auto write = writeIndex_.load(std::memory_order_acquire);
+        return static_cast<size_t>(std::min<uint64_t>(write - read, Capacity));
+    }
+
+private:
+    SharedRingBuffer() noexcept
+        : magic_(0), version_(Version), elementSize_(sizeof(T)), capacity_(Capacity), writeIndex_(0),
+          cachedReadIndex_(0), readIndex_(0), cachedWriteIndex_(0) {}
+
+    /**
+     * @brief Check that a mapping can hold the RingBuffer
+     * @param memory The mapping
+     * @param bytes The size of the mapping
+     * @return Whether it is large enough and suitably aligned
+     */
+    static bool Fits(void* memory, size_t bytes) noexcept {
+        return memory != nullptr && bytes >= RequiredBytes() &&
+               reinterpret_cast<uintptr_t>(memory) % alignof(SharedRingBuffer) == 0;
+    }
+
+private:
+    std::atomic<uint64_t> magic_; // Magic, non-zero once the RingBuffer is initialized
+    uint32_t version_; // Layout version
+    uint32_t elementSize_; // sizeof(T) of the creating process
+    uint64_t capacity_; // Capacity of the creating process
+    alignas(64) std::atomic<uint64_t> writeIndex_; // Write index
+    uint64_t cachedReadIndex_; // Producer-local copy of readIndex_
+    alignas(64) std::atomic<uint64_t> readIndex_; // Read index
+    uint64_t cachedWriteIndex_; // Consumer-local copy of writeIndex_
+    alignas(64) std::aligned_storage_t<sizeof(T), alignof(T)> slots_[Capacity]; // Buffer data
+};
+
+#if defined(__unix__) || defined(__APPLE__)
+/**
+ * @brief Owning mapping of a POSIX shared memory object, memfd or file, read-write unless mapped read-only
+ *
+ * Used to place a SharedRingBuffer in memory another process can map, for example
+ * SharedRingBuffer<Tick, 4096>::Create(region.Data(), region.Size()) in the producer and
+ * Attach() in the consumer. A default constructed or failed region is not Valid().
+ */
+class SharedMemoryRegion {
+public:
+    SharedMemoryRegion() noexcept = default;
+
+    SharedMemoryRegion(SharedMemoryRegion&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)),
+          fd_(std::exchange(other.fd_, -1)) {}
+
+    SharedMemoryRegion& operator=(SharedMemoryRegion&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            fd_ = std::exchange(other.fd_, -1);
+        }
+        return *this;
+    }
+
+    ~SharedMemoryRegion() { Reset(); }
+
+    /**
+     * @brief Create a new POSIX shared memory object and map it
+     * @param name The object name, e.g. "/md-feed"
+     * @param bytes The size of the object
+     * @return The region, not Valid() if the object exists already or cannot be created
+     */
+    static SharedMemoryRegion CreateShm(const char* name, size_t bytes) noexcept {
+        return MapFd(shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600), bytes, true);
+    }
+
+    /**
+     * @brief Open an existing POSIX shared memory object and map all of it
+     * @param name The object name
+     * @return The region, not Valid() on failure
+     */
+    static SharedMemoryRegion OpenShm(const char* name) noexcept {
+        return MapFd(shm_open(name, O_RDWR, 0), 0, false);
+    }
+
+    /**
+     * @brief Remove the name of a POSIX shared memory object, existing mappings stay valid
+     * @param name The object name
+     * @return Whether the name was removed
+     */
+    static bool UnlinkShm(const char* name) noexcept { return shm_unlink(name) == 0; }
+
+    /**
+     * @brief Map the first bytes of a file, creating it or growing it to bytes first
+     * @param path The file path
+     * @param bytes The size to map, or 0 to map the existing file as is
+     * @return The region, not Valid() on failure
+     * @note A file already larger than bytes keeps its size and contents beyond the mapping
+     */
+    static SharedMemoryRegion MapFile(const char* path, size_t bytes) noexcept {
+        const int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        bool grow = bytes != 0;
+        if (fd >= 0 && grow) {
+            struct stat status {};
+            grow = fstat(fd, &status) != 0 || static_cast<uint64_t>(status.st_size) < bytes;
+        }
+        return MapFd(fd, bytes, grow);
+    }
+
+#if defined(__linux__) && defined(SYS_memfd_create)
+    /**
+     * @brief Create an anonymous memfd and map it, share it by passing Fd() to the other process
+     * @param name The name shown in /proc, for debugging only
+     * @param bytes The size of the memfd
+     * @return The region, not Valid() on failure
+     */
+    static SharedMemoryRegion CreateMemfd(const char* name, size_t bytes) noexcept {
+        return MapFd(static_cast<int>(syscall(SYS_memfd_create, name, 0)), bytes, true);
+    }
+#endif
+
+    /**
+     * @brief Map an already open descriptor, taking ownership of it
+     * @param fd The descriptor, may be -1 to propagate an earlier failure
+     * @param bytes The size to map, or 0 to map the whole object
+     * @param resize Whether to set the object size to bytes first
+     * @param writable Whether to map it PROT_READ | PROT_WRITE; a PROT_READ mapping only needs an
+     *        O_RDONLY descriptor, cannot resize, and faults on any store through Data()
+     * @return The region, not Valid() on failure
+     */
+    static SharedMemoryRegion MapFd(int fd, size_t bytes, bool resize, bool writable = true) noexcept {
+        SharedMemoryRegion region;
+        if (fd < 0) {
+            return region;
+        }
+        region.fd_ = fd;
+        assert(writable || !resize);
+        if (resize && ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+            return SharedMemoryRegion();
+        }
+        if (bytes == 0) {
+            struct stat status {};
+            if (fstat(fd, &status) != 0 || status.st_size <= 0) {
+                return SharedMemoryRegion();
+            }
+            bytes = static_cast<size_t>(status.st_size);
+        }
+        void* data = mmap(nullptr, bytes, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            return SharedMemoryRegion();
+        }
+        region.data_ = data;
+        region.size_ = bytes;
+        return region;
+    }
+
+    /**
+     * @brief Whether the region is mapped
+     * @return Whether Data() points at the mapping
+     */
+    bool Valid() const noexcept { return data_ != nullptr; }
+
+    /**
+     * @brief Start of the mapping, page aligned
+     * @return The mapping, or nullptr if not Valid()
+     */
+    void* Data() const noexcept { return data_; }
+
+    /**
+     * @brief Length of the mapping
+     * @return The size in bytes
+     */
+    size_t Size() const noexcept { return size_; }
+
+    /**
+     * @brief Descriptor backing the mapping, e.g. to pass a memfd to another process
+     * @return The descriptor, or -1
+     */
+    int Fd() const noexcept { return fd_; }
+
+private:
+    /**
+     * @brief Unmap the region and close its descriptor
+     */
+    void Reset() noexcept {
+        if (data_ != nullptr) {
+            munmap(data_, size_);
+        }
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+        data_ = nullptr;
+        size_ = 0;
+        fd_ = -1;
+    }
+
+private:
+    void* data_ = nullptr; // Start of the mapping
+    size_t size_ = 0; // Length of the mapping
+    int fd_ = -1; // Descriptor backing the mapping
+};
+
+/**
+ * @brief One element as stored in a journal segment
+ */
+template <typename T>
+struct RingBufferJournalRecord {
+    uint64_t sequence; // Position of the element in the journal, counting from 0 across segments
+    uint64_t timestamp; // steady_clock nanoseconds when the batch holding the element was drained
+    T value; // The element
+};
+
+namespace ringbuffer_detail {
+
+/**
+ * @brief First 64 bytes of a journal segment file, followed by its records
+ */
+struct alignas(64) JournalHeader {
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "The replayer loads count from a read-only mapping.");
+
+    static constexpr uint64_t Magic = 0x4c4e524a4f4a4252; // "RBJOJRNL"
+    static constexpr uint32_t Version = 2; // Bumped whenever the layout changes
+
+    uint64_t magic; // Magic
+    uint32_t version; // Layout version
+    uint32_t recordSize; // sizeof(RingBufferJournalRecord<T>) of the writing process
+    uint64_t journalId; // Chosen by RingBufferJournalWriter::Open(), the same in every segment of one journal
+    uint64_t firstSequence; // Sequence number of the first record
+    uint64_t capacity; // Number of records the segment holds
+    std::atomic<uint64_t> count; // Records written, stored with release after each batch; the replayer only loads it, through a const header
+};
+
+/**
+ * @brief Path of one segment of a journal
+ * @param prefix The journal path prefix
+ * @param segment The segment number
+ * @return prefix followed by a six digit segment number, e.g. "feed.journal.000042"
+ */
+inline std::string JournalSegmentPath(const std::string& prefix, size_t segment) {
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".%06zu", segment);
+    return prefix + suffix;
+}
+
+/**
+ * @brief Identifier telling one journal apart from an earlier one written under the same prefix
+ * @return Wall clock, steady clock and process id mixed into 64 bits
+ */
+inline uint64_t NewJournalId() noexcept {
+    auto id = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+    id ^= RingBufferSteadyClock::Now() * 0x9e3779b97f4a7c15;
+    id ^= static_cast<uint64_t>(getpid()) << 40;
+    return id;
+}
+
+} // namespace ringbuffer_detail
+
+/**
+ * @brief Consumer-side adapter appending drained elements to memory-mapped journal segment files
+ *
+ * Drain() takes a batch from a RingBuffer through Consume() and copies it straight into the
+ * mapped segment, stamping each element with a sequence number and the drain time, so the
+ * producer's hot path is untouched. The timestamp is when the consumer drained the batch, not
+ * when the producer enqueued it. A full segment is unmapped and the next one created. The
+ * record count in the segment header is published after each batch, so a crash of the process
+ * loses at most the batch in flight; call Sync() to also survive power loss.
+ */
+template <typename T>
+class RingBufferJournalWriter {
+    static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable to be journaled.");
+    static_assert(alignof(T) <= 64, "Records are laid out after a 64-byte header.");
+
+public:
+    using Record = RingBufferJournalRecord<T>;
+
+    RingBufferJournalWriter() noexcept = default;
+    RingBufferJournalWriter(const RingBufferJournalWriter&) = delete;
+    RingBufferJournalWriter& operator=(const RingBufferJournalWriter&) = delete;
+
+    /**
+     * @brief Start a journal, creating or overwriting its first segment
+     * @param prefix The path prefix of the segment files
+     * @param recordsPerSegment The number of records per segment file
+     * @return Whether the first segment could be created
+     * @note Later segments left by an earlier journal with the same prefix are removed, and every
+     *       segment carries a fresh journal id, so a replay never continues into an older journal
+     */
+    bool Open(const std::string& prefix, size_t recordsPerSegment = size_t(1) << 16) {
+        assert(recordsPerSegment > 0);
+        prefix_ = prefix;
+        capacity_ = recordsPerSegment;
+        nextSequence_ = 0;
+        journalId_ = ringbuffer_detail::NewJournalId();
+        for (size_t segment = 1; unlink(ringbuffer_detail::JournalSegmentPath(prefix_, segment).c_str()) == 0; ++segment) {
+        }
+        return OpenSegment(0);
+    }
+
+    /**
+     * @brief Move up to maxBatch elements from a buffer into the journal
+     * @param buffer A buffer with a Consume(fn, maxBatch) drain, e.g. RingBuffer
+     * @param maxBatch The maximum number of elements to move
+     * @return The number of elements journaled, 0 when the buffer is empty or the next segment cannot be created
+     * @note A batch never spans two segments, so a call may return fewer elements than are available
+     */
+    template <typename Buffer>
+    size_t Drain(Buffer& buffer, size_t maxBatch = static_cast<size_t>(-1)) noexcept {
+        if (!region_.Valid() || (count_ == capacity_ && !OpenSegment(segment_ + 1))) {
+            return 0;
+        }
+        auto* records = Records();
+        const auto now = RingBufferSteadyClock::Now();
+        const auto consumed = buffer.Consume(
+            [&](T& value) noexcept {
+                auto& record = records[count_++];
+                record.sequence = nextSequence_++;
+                record.timestamp = now;
+                std::memcpy(std::addressof(record.value), std::addressof(value), sizeof(T));
+            },
+            std::min(maxBatch, capacity_ - count_));
+        // Release pairs with the acquire load in the replayer, making the records below the count visible
+        Header()->count.store(count_, std::memory_order_release);
+        return consumed;
+    }
+
+    /**
+     * @brief Flush the current segment to storage
+     * @return Whether msync succeeded
+     */
+    bool Sync() noexcept { return region_.Valid() && msync(region_.Data(), region_.Size(), MS_SYNC) == 0; }
+
+    /**
+     * @brief Sequence number the next journaled element gets
+     * @return The number of elements journaled since Open()
+     */
+    uint64_t NextSequence() const noexcept { return nextSequence_; }
+
+private:
+    ringbuffer_detail::JournalHeader* Header() noexcept {
+        return static_cast<ringbuffer_detail::JournalHeader*>(region_.Data());
+    }
+
+    Record* Records() noexcept { return reinterpret_cast<Record*>(Header() + 1); }
+
+    /**
+     * @brief Create a segment file and make it current, unmapping the previous one
+     * @param segment The segment number
+     * @return Whether the segment could be created
+     */
+    bool OpenSegment(size_t segment) noexcept {
+        try {
+            const auto path = ringbuffer_detail::JournalSegmentPath(prefix_, segment);
+            region_ = SharedMemoryRegion::MapFile(
+                path.c_str(), sizeof(ringbuffer_detail::JournalHeader) + capacity_ * sizeof(Record));
+        } catch (const std::bad_alloc&) {
+            region_ = SharedMemoryRegion();
+        }
+        if (!region_.Valid()) {
+            return false;
+        }
+        auto* header = new (region_.Data()) ringbuffer_detail::JournalHeader;
+        header->version = ringbuffer_detail::JournalHeader::Version;
+        header->recordSize = sizeof(Record);
+        header->journalId = journalId_;
+        header->firstSequence = nextSequence_;
+        header->capacity = capacity_;
+        header->count.store(0, std::memory_order_relaxed);
+        header->magic = ringbuffer_detail::JournalHeader::Magic;
+        segment_ = segment;
+        count_ = 0;
+        return true;
+    }
+
+private:
+    SharedMemoryRegion region_; // Mapping of the current segment
+    std::string prefix_; // Path prefix of the segment files
+    size_t capacity_ = 0; // Records per segment
+    size_t segment_ = 0; // Number of the current segment
+    size_t count_ = 0; // Records in the current segment
+    uint64_t nextSequence_ = 0; // Sequence number of the next record
+    uint64_t journalId_ = 0; // Id written into every segment header
+};
+
+/**
+ * @brief Feeds a journal written by RingBufferJournalWriter back into a buffer
+ */
+template <typename T>
+class RingBufferJournalReplayer {
+public:
+    using Record = RingBufferJournalRecord<T>;
+
+    enum class Rate {
+        Original, // Keep the recorded spacing between batches, i.e. when the consumer drained them
+        Maximum, // Write as fast as the buffer accepts
+    };
+
+    /**
+     * @brief Open a journal and check its first segment
+     * @param prefix The path prefix passed to RingBufferJournalWriter::Open()
+     * @return Whether the first segment exists and was written with the same record layout
+     */
+    bool Open(const std::string& prefix) {
+        prefix_ = prefix;
+        if (!MapSegment(0)) {
             return false;
         }
-        value = std::move(*reinterpret_cast<T*>(&buffer_[currentRead]));
-        reinterpret_cast<T*>(&buffer_[currentRead])->~T();
-        readIndex_.store(IncrementIndex(currentRead), std::memory_order_release);
+        journalId_ = static_cast<const ringbuffer_detail::JournalHeader*>(region_.Data())->journalId;
         return true;
     }
 
+    /**
+     * @brief Write every record of the journal to a buffer, from the first segment to the last
+     * @param buffer A buffer with a bool Write(const T&), e.g. RingBuffer; a full buffer is retried
+     * @param rate Whether to reproduce the recorded drain timing or replay at full speed
+     * @return The number of elements replayed
+     */
+    template <typename Buffer>
+    uint64_t Replay(Buffer& buffer, Rate rate = Rate::Maximum) noexcept {
+        uint64_t replayed = 0;
+        uint64_t firstStamp = 0;
+        const auto start = RingBufferSteadyClock::Now();
+        for (size_t segment = 0; MapSegment(segment); ++segment) {
+            const auto* header = static_cast<const ringbuffer_detail::JournalHeader*>(region_.Data());
+            if (header->journalId != journalId_ || header->firstSequence != replayed) {
+                // A leftover segment of an earlier journal with the same prefix
+                break;
+            }
+            const auto* records = reinterpret_cast<const Record*>(header + 1);
+            const auto count = header->count.load(std::memory_order_acquire);
+            for (uint64_t i = 0; i < count; ++i) {
+                const auto& record = records[i];
+                if (replayed == 0) {
+                    firstStamp = record.timestamp;
+                }
+                if (rate == Rate::Original) {
+                    WaitUntil(start + (record.timestamp - firstStamp));
+                }
+                while (!buffer.Write(record.value)) {
+                    std::this_thread::yield();
+                }
+                ++replayed;
+            }
+        }
+        return replayed;
+    }
+
 private:
     /**
-     * @brief Increment the index value to achieve circular buffer behavior
-     * @param index The current index value
-     * @return The incremented index value
+     * @brief Map one segment and validate its header
+     * @param segment The segment number
+     * @return Whether the segment exists and is compatible
      */
-    size_t IncrementIndex(size_t index) const noexcept {
-        static_assert(std::is_unsigned_v<decltype(index)>, "Index must be unsigned integer.");
-        static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2.");
-        return (index + 1) & (Capacity - 1);
+    bool MapSegment(size_t segment) noexcept {
+        try {
+            const auto path = ringbuffer_detail::JournalSegmentPath(prefix_, segment);
+            // Map without O_CREAT, so probing past the last segment leaves no empty file behind, and
+            // read-only, so replaying needs no write permission and cannot corrupt the journal
+            region_ = SharedMemoryRegion::MapFd(open(path.c_str(), O_RDONLY | O_CLOEXEC), 0, false, false);
+        } catch (const std::bad_alloc&) {
+            region_ = SharedMemoryRegion();
+        }
+        if (!region_.Valid() || region_.Size() < sizeof(ringbuffer_detail::JournalHeader)) {
+            return false;
+        }
+        const auto* header = static_cast<const ringbuffer_detail::JournalHeader*>(region_.Data());
+        return header->magic == ringbuffer_detail::JournalHeader::Magic &&
+               header->version == ringbuffer_detail::JournalHeader::Version && header->recordSize == sizeof(Record) &&
+               header->count.load(std::memory_order_acquire) <= header->capacity &&
+               region_.Size() >= sizeof(ringbuffer_detail::JournalHeader) + header->capacity * sizeof(Record);
+    }
+
+    /**
+     * @brief Wait until a steady_clock time, sleeping while it is far away and spinning for the last stretch
+     * @param deadline The time in steady_clock nanoseconds
+     */
+    static void WaitUntil(uint64_t deadline) noexcept {
+        constexpr uint64_t SpinNanoseconds = 100000;
+        for (auto now = RingBufferSteadyClock::Now(); now < deadline; now = RingBufferSteadyClock::Now()) {
+            if (deadline - now > SpinNanoseconds) {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(deadline - now - SpinNanoseconds));
+            } else {
+                ringbuffer_detail::CpuRelax();
+            }
+        }
     }
 
 private:
-    std::aligned_storage_t<sizeof(T), alignof(T)> buffer_[Capacity]; // Buffer data
-    alignas(64) std::atomic<size_t> readIndex_; // Read index
-    alignas(64) std::atomic<size_t> writeIndex_; // Write index
+    SharedMemoryRegion region_; // Mapping of the segment being replayed
+    std::string prefix_; // Path prefix of the segment files
+    uint64_t journalId_ = 0; // Id of the journal found by Open(), later segments must match it
 };
+#endif
 
 #endif // RINGBUFFER_HPP
@@ -0,0 +1,911 @@
+/**
+ * @file model_test.cpp
+ * @brief Exhaustive interleaving check of the ringbuffer.hpp synchronization protocols under the C++ memory model
+ *
+ * Each scenario is a few threads written as straight-line code that mirrors one path of the
+ * header, with every shared memory operation going through a small model of the C++ memory
+ * model. Atomic loads may return any store not older than one the thread has already observed
+ * or that happens-before it; read-modify-writes read the latest store and continue release
+ * sequences; release/acquire operations and fences carry vector clocks; a seq_cst fence makes
+ * the stores sequenced before it visible to loads after every later seq_cst fence; membarrier
+ * runs a full fence on every other thread; and a futex wait blocks until the word changes.
+ *
+ * The explorer runs the threads one shared operation at a time and, by replaying each thread
+ * from its start with the results it already got, visits every scheduling and every load result
+ * depth-first. A non-atomic slot access not ordered by happens-before is a data race, a state in
+ * which every thread left is blocked is a lost wake-up, and each scenario checks the values it
+ * transfers. Loops that keep finding a buffer full or empty are cut off after a few polls, and the
+ * scenarios with more than two threads or a second park bound how often an execution switches
+ * away from a thread that could go on, as CHESS does; the others are explored exhaustively.
+ *
+ * Scenarios, each run as written and then with one ordering or fence weakened or left out; the
+ * checker must find the bug in every such mutant, which shows that the orderings are necessary
+ * and that the check works:
+ *  - RingBuffer Write()/Read() with cached peer indices: the writeIndex/readIndex release/acquire pairs
+ *  - ReadBlocking() against Write()'s Notify(): the ParkingLot register/recheck handshake, with
+ *    LightBarrier()/HeavyBarrier() as seq_cst fences and with membarrier
+ *  - Lazy publishing: a waiting read claiming the pending write index, DeferPublish() seeing the
+ *    parked consumer, and the producer going idle without Flush()
+ *  - SeqlockSlot Store()/Load() with fences, and with the ordered words used under ThreadSanitizer
+ *  - MPSCRingBuffer and MPMCRingBuffer: the CAS position claim and the slot sequence hand-off
+ *
+ * Build: g++ -std=c++17 -O2 -I. tests/model_test.cpp -o model_test
+ * Usage: ./model_test   (exit code 0 on success)
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t kMaxThreads = 4;
+constexpr size_t kMaxSteps = 200; // Longer executions are cut off, none of the scenarios needs that many
+constexpr size_t kMaxPolls = 2;   // Loads of a full/empty buffer explored per element before cutting off
+
+using VectorClock = std::array<uint32_t, kMaxThreads>;
+
+VectorClock Join(const VectorClock& a, const VectorClock& b) noexcept {
+    VectorClock result{};
+    for (size_t i = 0; i < kMaxThreads; ++i) {
+        result[i] = std::max(a[i], b[i]);
+    }
+    return result;
+}
+
+enum class Order { Relaxed, Acquire, Release, AcqRel };
+
+bool IsAcquire(Order order) noexcept { return order == Order::Acquire || order == Order::AcqRel; }
+bool IsRelease(Order order) noexcept { return order == Order::Release || order == Order::AcqRel; }
+
+/**
+ * @brief One store in an atomic location's modification order
+ */
+struct Message {
+    uint64_t value;
+    size_t writer;      // Storing thread, kMaxThreads for the initial value
+    uint32_t stamp;     // Writer's own clock at the store
+    bool synchronizes;  // Whether an acquire reading it synchronizes with the writer
+    VectorClock clock;  // Clock an acquire reading it joins
+};
+
+/**
+ * @brief Non-atomic slot with the last access from each thread, for race detection
+ */
+struct Slot {
+    uint64_t value = 0;
+    bool written = false;
+    VectorClock lastWrite{}; // 0 means never
+    VectorClock lastRead{};
+};
+
+struct ThreadState {
+    VectorClock clock{};
+    VectorClock releaseFence{};       // Clock at the last release fence, carried by later relaxed stores
+    bool fenced = false;              // Whether a release fence was executed
+    VectorClock acquirePending{};     // Clocks of stores read by relaxed loads, joined by an acquire fence
+    std::vector<size_t> observed;     // Oldest message of each location the thread can still read
+    std::vector<size_t> ownStore;     // Latest message of each location the thread stored, plus one; 0 if none
+    std::vector<uint64_t> log;        // Result of every operation performed so far, replayed on the next step
+    size_t delivered = 0;             // Deliver() calls already counted
+    bool done = false;
+    bool waiting = false;             // The next operation is a futex wait on waitLocation
+    size_t waitLocation = 0;
+    uint64_t waitValue = 0;
+};
+
+class Model;
+using Program = std::function<void(Model&)>;
+
+/**
+ * @brief A protocol to explore: its atomic locations, non-atomic slots and threads
+ */
+struct Scenario {
+    const char* name;
+    std::vector<uint64_t> initial; // Initial value of each atomic location
+    size_t slots;
+    std::vector<Program> threads;
+    size_t deliveries = 0;  // When set, Deliver() must see every value below it exactly once
+    size_t preemptions = 0; // When set, executions switch away from a thread that could go on at most this often
+};
+
+struct Result {
+    uint64_t executions = 0; // Executions run to completion
+    uint64_t cutOff = 0;     // Executions stopped by kMaxPolls or kMaxSteps
+    std::string failure;     // First bug found, empty if none
+};
+
+class Model {
+public:
+    explicit Model(const Scenario& scenario) : scenario_(scenario) {}
+
+    Result Run() {
+        do {
+            depth_ = 0;
+            Execute();
+        } while (result_.failure.empty() && Backtrack());
+        return result_;
+    }
+
+    // Operations called by the thread programs, each one step of the thread
+
+    uint64_t Load(size_t location, Order order) {
+        if (Replaying()) {
+            return Replay();
+        }
+        auto& thread = Self();
+        Tick(current_);
+        const auto& messages = atomics_[location];
+        auto oldest = thread.observed[location];
+        for (size_t i = oldest; i < messages.size(); ++i) {
+            // A store that happens-before the load hides every older one
+            const auto& message = messages[i];
+            if (message.writer < kMaxThreads && message.stamp <= thread.clock[message.writer]) {
+                oldest = i;
+            }
+        }
+        const auto index = oldest + Choose(messages.size() - oldest);
+        Receive(thread, location, index, order);
+        return Record(messages[index].value);
+    }
+
+    void Store(size_t location, uint64_t value, Order order) {
+        if (Replaying()) {
+            Replay();
+            return;
+        }
+        Tick(current_);
+        Append(location, value, order, nullptr);
+        Record(0);
+    }
+
+    uint64_t FetchAdd(size_t location, uint64_t delta, Order order) {
+        if (Replaying()) {
+            return Replay();
+        }
+        Tick(current_);
+        const auto last = atomics_[location].size() - 1;
+        const auto previous = atomics_[location][last];
+        Receive(Self(), location, last, order);
+        Append(location, previous.value + delta, order, &previous);
+        return Record(previous.value);
+    }
+
+    bool CompareExchange(size_t location, uint64_t& expected, uint64_t desired, Order order) {
+        uint64_t value;
+        if (Replaying()) {
+            value = Replay();
+        } else {
+            Tick(current_);
+            const auto last = atomics_[location].size() - 1;
+            const auto previous = atomics_[location][last];
+            Receive(Self(), location, last, order);
+            if (previous.value == expected) {
+                Append(location, desired, order, &previous);
+            }
+            value = Record(previous.value);
+        }
+        if (value != expected) {
+            expected = value;
+            return false;
+        }
+        return true;
+    }
+
+    void Fence(Order order) {
+        if (Replaying()) {
+            Replay();
+            return;
+        }
+        Tick(current_);
+        auto& thread = Self();
+        if (IsAcquire(order)) {
+            thread.clock = Join(thread.clock, thread.acquirePending);
+        }
+        if (IsRelease(order)) {
+            thread.fenced = true;
+            thread.releaseFence = thread.clock;
+        }
+        Record(0);
+    }
+
+    void FenceSeqCst() {
+        if (Replaying()) {
+            Replay();
+            return;
+        }
+        SeqCstFence(current_);
+        Record(0);
+    }
+
+    /**
+     * @brief membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED): a full fence on every other thread, finished ones included
+     */
+    void Membarrier() {
+        if (Replaying()) {
+            Replay();
+            return;
+        }
+        SeqCstFence(current_);
+        for (size_t i = 0; i < threads_.size(); ++i) {
+            if (i != current_) {
+                SeqCstFence(i);
+            }
+        }
+        SeqCstFence(current_);
+        Record(0);
+    }
+
+    /**
+     * @brief Futex wait: blocks while the location holds value, then returns having read the latest store
+     */
+    void WaitWhileEqual(size_t location, uint64_t value) {
+        if (cursor_ < Self().log.size()) {
+            Replay();
+            return;
+        }
+        if (budget_ == 0) {
+            auto& thread = Self();
+            thread.waiting = true;
+            thread.waitLocation = location;
+            thread.waitValue = value;
+            throw Yield{};
+        }
+        --budget_;
+        Tick(current_);
+        Self().waiting = false;
+        Self().observed[location] = atomics_[location].size() - 1;
+        Record(0);
+    }
+
+    void WritePlain(size_t slot, uint64_t value) {
+        if (Replaying()) {
+            Replay();
+            return;
+        }
+        Tick(current_);
+        auto& entry = slots_[slot];
+        CheckRace(entry, true);
+        entry.value = value;
+        entry.written = true;
+        entry.lastWrite[current_] = Self().clock[current_];
+        Record(0);
+    }
+
+    uint64_t ReadPlain(size_t slot) {
+        if (Replaying()) {
+            return Replay();
+        }
+        Tick(current_);
+        auto& entry = slots_[slot];
+        CheckRace(entry, false);
+        if (!entry.written) {
+            Fail("read of a slot never written");
+        }
+        entry.lastRead[current_] = Self().clock[current_];
+        return Record(entry.value);
+    }
+
+    /**
+     * @brief Count a value as handed to the application, checked against Scenario::deliveries at the end
+     */
+    void Deliver(uint64_t value) {
+        auto& thread = Self();
+        if (deliveryCursor_++ < thread.delivered) {
+            return;
+        }
+        ++thread.delivered;
+        if (value >= delivered_.size() || ++delivered_[value] > 1) {
+            Fail("element delivered twice or never written");
+        }
+    }
+
+    [[noreturn]] void Fail(const char* what) {
+        result_.failure = what;
+        throw Stop{};
+    }
+
+    [[noreturn]] void CutOff() {
+        ++result_.cutOff;
+        throw Stop{};
+    }
+
+private:
+    struct Yield {}; // The thread reached an operation it has no budget for
+    struct Stop {};  // The execution ends here, failed or cut off
+
+    struct Choice {
+        size_t chosen;
+        size_t count;
+    };
+
+    ThreadState& Self() noexcept { return threads_[current_]; }
+
+    void Tick(size_t index) noexcept { ++threads_[index].clock[index]; }
+
+    /**
+     * @brief Whether the operation at the cursor was performed in an earlier step; otherwise use up the budget
+     */
+    bool Replaying() {
+        auto& thread = Self();
+        if (cursor_ < thread.log.size()) {
+            return true;
+        }
+        if (budget_ == 0) {
+            thread.waiting = false;
+            throw Yield{};
+        }
+        --budget_;
+        return false;
+    }
+
+    uint64_t Replay() noexcept { return Self().log[cursor_++]; }
+
+    uint64_t Record(uint64_t value) {
+        Self().log.push_back(value);
+        ++cursor_;
+        return value;
+    }
+
+    void Receive(ThreadState& thread, size_t location, size_t index, Order order) {
+        thread.observed[location] = std::max(thread.observed[location], index);
+        const auto& message = atomics_[location][index];
+        if (message.synchronizes) {
+            if (IsAcquire(order)) {
+                thread.clock = Join(thread.clock, message.clock);
+            } else {
+                thread.acquirePending = Join(thread.acquirePending, message.clock);
+            }
+        }
+    }
+
+    /**
+     * @brief Add a store to a location's modification order
+     * @param previous The message a read-modify-write read, continuing its release sequence; nullptr for a plain store
+     */
+    void Append(size_t location, uint64_t value, Order order, const Message* previous) {
+        auto& thread = Self();
+        Message message{value, current_, thread.clock[current_], false, VectorClock{}};
+        if (IsRelease(order)) {
+            message.synchronizes = true;
+            message.clock = thread.clock;
+        } else if (thread.fenced) {
+            message.synchronizes = true;
+            message.clock = thread.releaseFence;
+        }
+        if (previous != nullptr && previous->synchronizes) {
+            message.synchronizes = true;
+            message.clock = Join(message.clock, previous->clock);
+        }
+        auto& messages = atomics_[location];
+        messages.push_back(message);
+        thread.observed[location] = messages.size() - 1;
+        thread.ownStore[location] = messages.size();
+    }
+
+    /**
+     * @brief seq_cst fence: acquire and release, and ordered with every other seq_cst fence
+     * @note A store sequenced before a fence is visible to loads sequenced after any later fence
+     */
+    void SeqCstFence(size_t index) {
+        Tick(index);
+        auto& thread = threads_[index];
+        thread.clock = Join(thread.clock, thread.acquirePending);
+        thread.fenced = true;
+        thread.releaseFence = thread.clock;
+        for (size_t location = 0; location < atomics_.size(); ++location) {
+            if (thread.ownStore[location] != 0) {
+                fenceFloor_[location] = std::max(fenceFloor_[location], thread.ownStore[location] - 1);
+            }
+            thread.observed[location] = std::max(thread.observed[location], fenceFloor_[location]);
+        }
+    }
+
+    void CheckRace(const Slot& entry, bool write) {
+        const auto& clock = Self().clock;
+        for (size_t other = 0; other < threads_.size(); ++other) {
+            if (other != current_ &&
+                (entry.lastWrite[other] > clock[other] || (write && entry.lastRead[other] > clock[other]))) {
+                Fail("data race on a slot");
+            }
+        }
+    }
+
+    size_t Choose(size_t count) {
+        if (count == 1) {
+            return 0;
+        }
+        if (depth_ < choices_.size()) {
+            return choices_[depth_++].chosen;
+        }
+        choices_.push_back(Choice{0, count});
+        ++depth_;
+        return 0;
+    }
+
+    bool Backtrack() {
+        while (!choices_.empty() && choices_.back().chosen + 1 == choices_.back().count) {
+            choices_.pop_back();
+        }
+        if (choices_.empty()) {
+            return false;
+        }
+        ++choices_.back().chosen;
+        return true;
+    }
+
+    /**
+     * @brief Run a thread from its start, replaying what it did so far, until it needs more than budget operations
+     */
+    void Step(size_t index, size_t budget) {
+        current_ = index;
+        cursor_ = 0;
+        deliveryCursor_ = 0;
+        budget_ = budget;
+        try {
+            scenario_.threads[index](*this);
+            threads_[index].done = true;
+        } catch (const Yield&) {
+        }
+    }
+
+    bool Enabled(const ThreadState& thread) const {
+        return !thread.done &&
+               !(thread.waiting && atomics_[thread.waitLocation].back().value == thread.waitValue);
+    }
+
+    void Execute() {
+        const auto locations = scenario_.initial.size();
+        atomics_.assign(locations, {});
+        for (size_t i = 0; i < locations; ++i) {
+            // Initial values, ordered before every thread
+            atomics_[i].push_back(Message{scenario_.initial[i], kMaxThreads, 0, false, VectorClock{}});
+        }
+        fenceFloor_.assign(locations, 0);
+        slots_.assign(scenario_.slots, Slot{});
+        delivered_.assign(scenario_.deliveries, 0);
+        threads_.assign(scenario_.threads.size(), ThreadState{});
+        for (auto& thread : threads_) {
+            thread.observed.assign(locations, 0);
+            thread.ownStore.assign(locations, 0);
+        }
+        try {
+            for (size_t i = 0; i < threads_.size(); ++i) {
+                Step(i, 0);
+            }
+            size_t last = kMaxThreads;
+            size_t preemptions = 0;
+            for (size_t steps = 0;; ++steps) {
+                size_t enabled[kMaxThreads];
+                size_t count = 0;
+                bool blocked = false;
+                const bool preemptible = last == kMaxThreads || !Enabled(threads_[last]) ||
+                                         scenario_.preemptions == 0 || preemptions < scenario_.preemptions;
+                for (size_t i = 0; i < threads_.size(); ++i) {
+                    if (Enabled(threads_[i]) && (preemptible || i == last)) {
+                        enabled[count++] = i;
+                    } else if (!threads_[i].done) {
+                        blocked = true;
+                    }
+                }
+                if (count == 0) {
+                    if (blocked) {
+                        Fail("lost wake-up: every thread left is blocked");
+                    }
+                    break;
+                }
+                if (steps == kMaxSteps) {
+                    CutOff();
+                }
+                const auto next = enabled[Choose(count)];
+                if (next != last && last != kMaxThreads && Enabled(threads_[last])) {
+                    ++preemptions;
+                }
+                last = next;
+                Step(next, 1);
+            }
+            if (std::any_of(delivered_.begin(), delivered_.end(), [](uint32_t count) { return count != 1; })) {
+                Fail("element lost");
+            }
+            ++result_.executions;
+        } catch (const Stop&) {
+        }
+    }
+
+    const Scenario& scenario_;
+    Result result_;
+    std::vector<Choice> choices_; // Decisions of the current execution, varied from the back
+    size_t depth_ = 0;            // Decisions taken so far in the current execution
+
+    std::vector<std::vector<Message>> atomics_; // Modification order of each atomic location
+    std::vector<size_t> fenceFloor_;            // Per location, oldest message loads after the next seq_cst fence may read
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> delivered_;
+    std::vector<ThreadState> threads_;
+    size_t current_ = 0;        // Thread being stepped
+    size_t cursor_ = 0;         // Its next operation
+    size_t deliveryCursor_ = 0; // Its next Deliver() call
+    size_t budget_ = 0;         // Operations it may still perform in this step
+};
+
+// RingBuffer Write()/Read(): each side refreshes its cached copy of the other's index only when
+// the buffer looks full/empty, and publishes its own index after the slot access
+Scenario SpscIndices(const char* name, Order publishWrite, Order publishRead) {
+    enum : size_t { kWriteIndex, kReadIndex };
+    constexpr uint64_t kCapacity = 2; // Power of two, as in RingBuffer
+    constexpr uint64_t kElements = 3; // More than the capacity, so a slot is reused after wrapping
+    const auto acquireWrite = publishWrite == Order::Release ? Order::Acquire : Order::Relaxed;
+    const auto acquireRead = publishRead == Order::Release ? Order::Acquire : Order::Relaxed;
+    auto producer = [=](Model& model) {
+        uint64_t cachedRead = 0;
+        for (uint64_t write = 0; write < kElements; ++write) {
+            for (size_t polls = 0; kCapacity - (write - cachedRead) == 0; ++polls) {
+                if (polls == kMaxPolls) {
+                    model.CutOff();
+                }
+                cachedRead = model.Load(kReadIndex, acquireRead);
+            }
+            model.WritePlain(write % kCapacity, write);
+            model.Store(kWriteIndex, write + 1, publishWrite);
+        }
+    };
+    auto consumer = [=](Model& model) {
+        uint64_t cachedWrite = 0;
+        for (uint64_t read = 0; read < kElements; ++read) {
+            for (size_t polls = 0; cachedWrite - read == 0; ++polls) {
+                if (polls == kMaxPolls) {
+                    model.CutOff();
+                }
+                cachedWrite = model.Load(kWriteIndex, acquireWrite);
+            }
+            if (model.ReadPlain(read % kCapacity) != read) {
+                model.Fail("element read out of order");
+            }
+            model.Store(kReadIndex, read + 1, publishRead);
+        }
+    };
+    return Scenario{name, {0, 0}, kCapacity, {producer, consumer}};
+}
+
+/**
+ * @brief How LightBarrier()/HeavyBarrier() are compiled in a scenario
+ */
+enum class Barriers {
+    Fences,      // Without membarrier: both halves are seq_cst fences
+    Membarrier,  // With membarrier: the light half is compiler-only, the heavy half adds membarrier
+    HeavyOnly,   // Mutant: light half compiler-only but no membarrier to make up for it
+    None,        // Mutant: no barrier at all
+};
+
+void LightBarrier(Model& model, Barriers barriers) {
+    if (barriers == Barriers::Fences) {
+        model.FenceSeqCst();
+    }
+}
+
+void HeavyBarrier(Model& model, Barriers barriers) {
+    if (barriers != Barriers::None) {
+        model.FenceSeqCst();
+    }
+    if (barriers == Barriers::Membarrier) {
+        model.Membarrier();
+    }
+}
+
+enum : size_t { kWaiters, kEpoch, kParkLocations }; // ParkingLot state, the first locations of the parking scenarios
+
+// ParkingLot::Notify(), without the AsyncWaiter
+void Notify(Model& model, Barriers barriers) {
+    LightBarrier(model, barriers);
+    if (model.Load(kWaiters, Order::Relaxed) != 0) {
+        model.FetchAdd(kEpoch, 1, Order::Release);
+    }
+}
+
+// BlockUntil(op) and ParkingLot::Park(op) with one attempt before parking instead of the spin phase;
+// after a wake-up or a spurious return it loops, as BlockUntil() does
+template <typename Op>
+void BlockUntil(Model& model, Barriers barriers, Op&& op) {
+    if (op()) {
+        return;
+    }
+    for (;;) {
+        const auto epoch = model.Load(kEpoch, Order::Acquire);
+        model.FetchAdd(kWaiters, 1, Order::AcqRel);
+        HeavyBarrier(model, barriers);
+        const bool ready = op();
+        if (!ready) {
+            model.WaitWhileEqual(kEpoch, epoch);
+        }
+        model.FetchAdd(kWaiters, static_cast<uint64_t>(-1), Order::Release);
+        if (ready) {
+            return;
+        }
+    }
+}
+
+// ReadBlocking() against Write(): the consumer parks on the readers lot, the producer publishes and
+// notifies. Two elements make the consumer park again after a wake-up, which is only explored with
+// a preemption bound
+Scenario ParkNotify(const char* name, Barriers barriers, uint64_t elements, size_t preemptions) {
+    enum : size_t { kWriteIndex = kParkLocations };
+    auto producer = [=](Model& model) {
+        for (uint64_t write = 0; write < elements; ++write) {
+            model.WritePlain(write, write);
+            model.Store(kWriteIndex, write + 1, Order::Release);
+            Notify(model, barriers);
+        }
+    };
+    auto consumer = [=](Model& model) {
+        uint64_t cachedWrite = 0;
+        for (uint64_t read = 0; read < elements; ++read) {
+            BlockUntil(model, barriers, [&] {
+                if (cachedWrite == read) {
+                    cachedWrite = model.Load(kWriteIndex, Order::Acquire);
+                }
+                return cachedWrite != read;
+            });
+            if (model.ReadPlain(read) != read) {
+                model.Fail("element read out of order");
+            }
+        }
+    };
+    return Scenario{name, {0, 0, 0}, elements, {producer, consumer}, 0, preemptions};
+}
+
+/**
+ * @brief Which part of the lazy publishing handshake a scenario leaves out or weakens
+ */
+enum class LazyMutant { None, NoClaim, NoWaiterCheck, RelaxedLocalIndex };
+
+// Lazy publishing with a count threshold never reached: the producer writes, publishes only when
+// DeferPublish() sees a parked consumer, then goes idle without Flush(); the consumer reads with
+// ReadBlocking(), whose WaitingRead() falls back to ClaimPending()
+Scenario LazyPublish(const char* name, LazyMutant mutant, uint64_t elements, size_t preemptions) {
+    enum : size_t { kWriteIndex = kParkLocations, kLocalWriteIndex };
+    constexpr auto barriers = Barriers::Fences;
+    auto producer = [=](Model& model) {
+        for (uint64_t write = 0; write < elements; ++write) {
+            model.WritePlain(write, write);
+            model.Store(kLocalWriteIndex, write + 1,
+                        mutant == LazyMutant::RelaxedLocalIndex ? Order::Relaxed : Order::Release);
+            if (mutant != LazyMutant::NoWaiterCheck) {
+                // DeferPublish(): readers_.HasWaiters()
+                LightBarrier(model, barriers);
+                if (model.Load(kWaiters, Order::Relaxed) != 0) {
+                    model.Store(kWriteIndex, write + 1, Order::Release);
+                    Notify(model, barriers);
+                }
+            }
+        }
+    };
+    auto consumer = [=](Model& model) {
+        uint64_t cachedWrite = 0;
+        for (uint64_t read = 0; read < elements; ++read) {
+            BlockUntil(model, barriers, [&] {
+                if (cachedWrite == read) {
+                    // RefreshWriteIndex(), never stepping back behind a claimed index
+                    cachedWrite = std::max(cachedWrite, model.Load(kWriteIndex, Order::Acquire));
+                }
+                if (cachedWrite == read && mutant != LazyMutant::NoClaim) {
+                    // ClaimPending()
+                    cachedWrite = model.Load(kLocalWriteIndex, Order::Acquire);
+                }
+                return cachedWrite != read;
+            });
+            if (model.ReadPlain(read) != read) {
+                model.Fail("element read out of order");
+            }
+        }
+    };
+    return Scenario{name, {0, 0, 0, 0}, elements, {producer, consumer}, 0, preemptions};
+}
+
+/**
+ * @brief How SeqlockSlot orders its payload words in a scenario
+ */
+enum class SeqlockOrders {
+    Fences,         // As compiled normally: relaxed words between a release and an acquire fence
+    OrderedWords,   // As compiled under ThreadSanitizer: release/acquire words, no fences
+    NoWriterFence,  // Mutant
+    NoReaderFence,  // Mutant
+};
+
+// SeqlockSlot Store() overwriting one slot while Load() reads it, as in OverwriteRingBuffer
+Scenario Seqlock(const char* name, SeqlockOrders orders) {
+    enum : size_t { kSequence, kWord0, kWord1 };
+    constexpr uint64_t kPositions = 2;
+    constexpr size_t kReads = 1;
+    const bool writerFence = orders == SeqlockOrders::Fences || orders == SeqlockOrders::NoReaderFence;
+    const bool readerFence = orders == SeqlockOrders::Fences || orders == SeqlockOrders::NoWriterFence;
+    const auto storeOrder = orders == SeqlockOrders::OrderedWords ? Order::Release : Order::Relaxed;
+    const auto loadOrder = orders == SeqlockOrders::OrderedWords ? Order::Acquire : Order::Relaxed;
+    auto writer = [=](Model& model) {
+        for (uint64_t position = 0; position < kPositions; ++position) {
+            model.Store(kSequence, 2 * position + 1, Order::Relaxed);
+            if (writerFence) {
+                model.Fence(Order::Release);
+            }
+            // Both words of position p hold p + 1, so a mix of two positions shows
+            model.Store(kWord0, position + 1, storeOrder);
+            model.Store(kWord1, position + 1, storeOrder);
+            model.Store(kSequence, 2 * position + 2, Order::Release);
+        }
+    };
+    auto reader = [=](Model& model) {
+        for (size_t attempt = 0; attempt < kReads; ++attempt) {
+            const auto before = model.Load(kSequence, Order::Acquire);
+            if (before == 0 || before % 2 != 0) {
+                continue;
+            }
+            const auto word0 = model.Load(kWord0, loadOrder);
+            const auto word1 = model.Load(kWord1, loadOrder);
+            if (readerFence) {
+                model.Fence(Order::Acquire);
+            }
+            if (model.Load(kSequence, Order::Relaxed) == before && (word0 != before / 2 || word1 != before / 2)) {
+                model.Fail("torn element accepted");
+            }
+        }
+    };
+    return Scenario{name, {0, 0, 0}, 0, {writer, reader}};
+}
+
+/**
+ * @brief Which slot sequence store a claim scenario weakens
+ */
+enum class ClaimMutant { None, RelaxedProducerPublish, RelaxedConsumerRelease };
+
+constexpr uint64_t kClaimCapacity = 2; // One slot would make the published and the released sequence equal
+
+// MPMCRingBuffer::Emplace(), shared by MPSCRingBuffer: claim the position with a CAS once the slot is free
+bool ClaimWrite(Model& model, uint64_t value, ClaimMutant mutant) {
+    enum : size_t { kWriteIndex, kReadIndex, kSequence };
+    auto position = model.Load(kWriteIndex, Order::Relaxed);
+    for (size_t polls = 0;; ++polls) {
+        if (polls == kMaxPolls) {
+            model.CutOff();
+        }
+        const auto sequence = model.Load(kSequence + position % kClaimCapacity, Order::Acquire);
+        const auto diff = static_cast<int64_t>(sequence - position);
+        if (diff == 0) {
+            if (model.CompareExchange(kWriteIndex, position, position + 1, Order::Relaxed)) {
+                model.WritePlain(position % kClaimCapacity, value);
+                model.Store(kSequence + position % kClaimCapacity, position + 1,
+                            mutant == ClaimMutant::RelaxedProducerPublish ? Order::Relaxed : Order::Release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            position = model.Load(kWriteIndex, Order::Relaxed);
+        }
+    }
+}
+
+// A producer writing the values in [first, last), retrying while full
+Program ClaimProducer(uint64_t first, uint64_t last, ClaimMutant mutant) {
+    return [=](Model& model) {
+        for (uint64_t value = first; value < last; ++value) {
+            for (size_t polls = 0; !ClaimWrite(model, value, mutant); ++polls) {
+                if (polls + 1 == kMaxPolls) {
+                    model.CutOff();
+                }
+            }
+        }
+    };
+}
+
+// MPSCRingBuffer with two producers and the single consumer, which owns the read index
+Scenario Mpsc(const char* name, ClaimMutant mutant) {
+    enum : size_t { kWriteIndex, kReadIndex, kSequence };
+    constexpr uint64_t kElements = 3; // Values 0 and 1 from the first producer, 2 from the second
+    auto consumer = [=](Model& model) {
+        uint64_t next[2] = {0, 2};
+        for (uint64_t read = 0; read < kElements; ++read) {
+            for (size_t polls = 0; model.Load(kSequence + read % kClaimCapacity, Order::Acquire) != read + 1; ++polls) {
+                if (polls + 1 == kMaxPolls) {
+                    model.CutOff();
+                }
+            }
+            const auto value = model.ReadPlain(read % kClaimCapacity);
+            model.Store(kSequence + read % kClaimCapacity, read + kClaimCapacity,
+                        mutant == ClaimMutant::RelaxedConsumerRelease ? Order::Relaxed : Order::Release);
+            // Each producer's elements arrive in the order it wrote them
+            if (value != next[value / 2]++) {
+                model.Fail("element read out of order");
+            }
+            model.Deliver(value);
+        }
+    };
+    return Scenario{name,
+                    {0, 0, 0, 1},
+                    kClaimCapacity,
+                    {ClaimProducer(0, 2, mutant), ClaimProducer(2, kElements, mutant), consumer},
+                    kElements,
+                    3}; // Three threads are too many to interleave without a bound
+}
+
+// MPMCRingBuffer::Read(): claim the position with a CAS once the slot holds its element
+Scenario Mpmc(const char* name, ClaimMutant mutant) {
+    enum : size_t { kWriteIndex, kReadIndex, kSequence };
+    auto consumer = [=](Model& model) {
+        for (size_t attempts = 0;; ++attempts) {
+            if (attempts == kMaxPolls) {
+                model.CutOff();
+            }
+            auto position = model.Load(kReadIndex, Order::Relaxed);
+            for (size_t polls = 0; polls < kMaxPolls; ++polls) {
+                const auto sequence = model.Load(kSequence + position % kClaimCapacity, Order::Acquire);
+                const auto diff = static_cast<int64_t>(sequence - (position + 1));
+                if (diff == 0) {
+                    if (model.CompareExchange(kReadIndex, position, position + 1, Order::Relaxed)) {
+                        model.Deliver(model.ReadPlain(position % kClaimCapacity));
+                        model.Store(kSequence + position % kClaimCapacity, position + kClaimCapacity,
+                                    mutant == ClaimMutant::RelaxedConsumerRelease ? Order::Relaxed : Order::Release);
+                        return;
+                    }
+                } else if (diff < 0) {
+                    break;
+                } else {
+                    position = model.Load(kReadIndex, Order::Relaxed);
+                }
+            }
+        }
+    };
+    return Scenario{name,
+                    {0, 0, 0, 1},
+                    kClaimCapacity,
+                    {ClaimProducer(0, 1, mutant), ClaimProducer(1, 2, mutant), consumer, consumer},
+                    2,
+                    2};
+}
+
+bool Report(const Scenario& scenario, bool expectClean) {
+    const auto result = Model(scenario).Run();
+    const bool clean = result.failure.empty();
+    const bool passed = clean ? expectClean && result.executions > 0 : !expectClean;
+    std::printf("%-32s executions=%-8llu cut off=%-7llu %-44s %s\n", scenario.name,
+                static_cast<unsigned long long>(result.executions), static_cast<unsigned long long>(result.cutOff),
+                clean ? "clean" : result.failure.c_str(), passed ? "ok" : "FAILED");
+    std::fflush(stdout);
+    return passed;
+}
+
+} // namespace
+
+int main() {
+    bool passed = true;
+    passed &= Report(SpscIndices("spsc release/acquire", Order::Release, Order::Release), true);
+    passed &= Report(SpscIndices("spsc relaxed writeIndex", Order::Relaxed, Order::Release), false);
+    passed &= Report(SpscIndices("spsc relaxed readIndex", Order::Release, Order::Relaxed), false);
+
+    passed &= Report(ParkNotify("park fences", Barriers::Fences, 1, 0), true);
+    passed &= Report(ParkNotify("park membarrier", Barriers::Membarrier, 1, 0), true);
+    passed &= Report(ParkNotify("park fences, park again", Barriers::Fences, 2, 4), true);
+    passed &= Report(ParkNotify("park membarrier, park again", Barriers::Membarrier, 2, 4), true);
+    passed &= Report(ParkNotify("park no membarrier", Barriers::HeavyOnly, 1, 0), false);
+    passed &= Report(ParkNotify("park no barriers", Barriers::None, 1, 0), false);
+
+    passed &= Report(LazyPublish("lazy claim", LazyMutant::None, 1, 0), true);
+    passed &= Report(LazyPublish("lazy claim, two elements", LazyMutant::None, 2, 3), true);
+    passed &= Report(LazyPublish("lazy no claim", LazyMutant::NoClaim, 1, 0), false);
+    passed &= Report(LazyPublish("lazy no waiter check", LazyMutant::NoWaiterCheck, 1, 0), false);
+    passed &= Report(LazyPublish("lazy relaxed localWriteIndex", LazyMutant::RelaxedLocalIndex, 1, 0), false);
+
+    passed &= Report(Seqlock("seqlock fences", SeqlockOrders::Fences), true);
+    passed &= Report(Seqlock("seqlock ordered words (tsan)", SeqlockOrders::OrderedWords), true);
+    passed &= Report(Seqlock("seqlock no writer fence", SeqlockOrders::NoWriterFence), false);
+    passed &= Report(Seqlock("seqlock no reader fence", SeqlockOrders::NoReaderFence), false);
+
+    passed &= Report(Mpsc("mpsc claim", ClaimMutant::None), true);
+    passed &= Report(Mpsc("mpsc relaxed producer publish", ClaimMutant::RelaxedProducerPublish), false);
+    passed &= Report(Mpsc("mpsc relaxed consumer release", ClaimMutant::RelaxedConsumerRelease), false);
+    passed &= Report(Mpmc("mpmc claim", ClaimMutant::None), true);
+    passed &= Report(Mpmc("mpmc relaxed producer publish", ClaimMutant::RelaxedProducerPublish), false);
+    return passed ? 0 : 1;
+}
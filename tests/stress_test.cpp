@@ -0,0 +1,537 @@
+/**
+ * @file stress_test.cpp
+ * @brief ThreadSanitizer stress test of every queue: producer and consumer threads hammer each
+ *        interface while TSAN checks each cross-thread access is ordered
+ *
+ * Covers RingBuffer single, bulk, Consume(), blocking (park/unpark) and lazily published transfers,
+ * ByteRingBuffer records that wrap around through padding, the ParkingLot register/notify
+ * handshake and the eventfd notification, then MPMCRingBuffer, MPSCRingBuffer, ShardedRingBuffer,
+ * OverwriteRingBuffer, BroadcastRingBuffer (lossless and lossy), UnboundedRingBuffer and
+ * PriorityRingBuffer. Every transfer also checks the data arrives complete, once and in order, and
+ * every wait has a deadline: a side that makes no progress for ten seconds fails the test instead
+ * of hanging it.
+ *
+ * Under -fsanitize=thread the header replaces its fences with atomic operations TSAN models, so
+ * the barrier and seqlock paths are checked too and no -Wtsan warning is expected.
+ *
+ * Build: g++ -std=c++17 -O1 -g -fsanitize=thread -pthread -I. tests/stress_test.cpp -o stress_test
+ * Usage: ./stress_test [iterations]   (exit code 0 on success)
+ */
+
+#include "ringbuffer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <poll.h>
+#endif
+
+namespace {
+
+#define CHECK(condition)                                                                       \
+    do {                                                                                       \
+        if (!(condition)) {                                                                    \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            std::exit(1);                                                                      \
+        }                                                                                      \
+    } while (0)
+
+constexpr auto kDeadline = std::chrono::seconds(10); // Longest a side may go without progress
+
+/**
+ * @brief Retry op, yielding between attempts, and fail the test if it does not succeed before the deadline
+ * @param op Returns a value that converts to true on success, e.g. a bool or an element count
+ * @return The first successful result of op
+ */
+template <typename Op>
+auto Retry(Op&& op) {
+    const auto deadline = std::chrono::steady_clock::now() + kDeadline;
+    for (;;) {
+        if (const auto result = op()) {
+            return result;
+        }
+        CHECK(std::chrono::steady_clock::now() < deadline);
+        std::this_thread::yield();
+    }
+}
+
+/**
+ * @brief Element bigger than a word, so a torn or stale read shows up as a checksum mismatch
+ */
+struct Message {
+    uint64_t sequence;
+    uint64_t payload[3];
+
+    static Message Make(uint64_t sequence) noexcept {
+        return Message{sequence, {sequence * 3, ~sequence, sequence ^ 0x5a5a5a5a}};
+    }
+
+    bool Valid(uint64_t expected) const noexcept {
+        const auto reference = Make(expected);
+        return sequence == reference.sequence && payload[0] == reference.payload[0] &&
+               payload[1] == reference.payload[1] && payload[2] == reference.payload[2];
+    }
+
+    bool Valid() const noexcept { return Valid(sequence); }
+};
+
+/**
+ * @brief Delivery record of a multi-producer or multi-consumer test
+ *
+ * Producer p sends sequences p * iterations up to (p + 1) * iterations. Each consumer checks that
+ * it sees every producer's sequences in increasing order and keeps what it got; merged after the
+ * threads are joined, every sequence must have arrived exactly once.
+ */
+class Deliveries {
+public:
+    /**
+     * @brief Per-consumer state
+     */
+    struct Consumer {
+        explicit Consumer(size_t producers) : next(producers, 0) {}
+
+        std::vector<uint64_t> next; // Index of the first message each producer may still deliver
+        std::vector<uint64_t> received; // Sequences received, in order
+    };
+
+    Deliveries(size_t producers, size_t iterations) : iterations_(iterations), counts_(producers * iterations, 0) {}
+
+    void Receive(Consumer& consumer, const Message& message) const {
+        CHECK(message.Valid());
+        const auto producer = message.sequence / iterations_;
+        const auto index = message.sequence % iterations_;
+        CHECK(producer < consumer.next.size());
+        CHECK(index >= consumer.next[producer]);
+        consumer.next[producer] = index + 1;
+        consumer.received.push_back(message.sequence);
+    }
+
+    void Merge(const Consumer& consumer) {
+        for (const auto sequence : consumer.received) {
+            ++counts_[sequence];
+        }
+    }
+
+    bool Complete() const {
+        return std::all_of(counts_.begin(), counts_.end(), [](uint32_t count) { return count == 1; });
+    }
+
+private:
+    size_t iterations_; // Messages per producer
+    std::vector<uint32_t> counts_; // Times each sequence was received
+};
+
+void StressSingle(size_t iterations) {
+    RingBuffer<Message, 16> buffer;
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            Retry([&] { return buffer.Write(Message::Make(i)); });
+        }
+    });
+    Message message{};
+    for (uint64_t i = 0; i < iterations; ++i) {
+        Retry([&] { return buffer.Read(message); });
+        CHECK(message.Valid(i));
+    }
+    producer.join();
+    CHECK(buffer.Empty());
+}
+
+void StressBulk(size_t iterations) {
+    RingBuffer<Message, 64> buffer;
+    std::thread producer([&] {
+        Message batch[23];
+        for (uint64_t next = 0; next < iterations;) {
+            const auto count = std::min<size_t>(1 + next % 23, iterations - next);
+            for (size_t i = 0; i < count; ++i) {
+                batch[i] = Message::Make(next + i);
+            }
+            next += Retry([&] { return buffer.WriteBulk(batch, count); });
+        }
+    });
+    Message batch[17];
+    for (uint64_t next = 0; next < iterations;) {
+        const auto read = Retry([&] { return buffer.ReadBulk(batch, 1 + next % 17); });
+        for (size_t i = 0; i < read; ++i) {
+            CHECK(batch[i].Valid(next + i));
+        }
+        next += read;
+    }
+    producer.join();
+}
+
+void StressConsume(size_t iterations) {
+    RingBuffer<Message, 32> buffer;
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            Retry([&] { return buffer.Emplace(Message::Make(i)); });
+        }
+    });
+    uint64_t next = 0;
+    while (next < iterations) {
+        Retry([&] { return buffer.Consume([&](Message& message) { CHECK(message.Valid(next++)); }, 1 + next % 9); });
+    }
+    producer.join();
+}
+
+void StressBlocking(size_t iterations) {
+    // Capacity 2 keeps both sides parking and waking each other all the time. The timed variants
+    // park exactly like WriteBlocking()/ReadBlocking(), but a lost wake-up fails instead of hanging
+    RingBuffer<Message, 2> buffer;
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            CHECK(buffer.TryWriteFor(Message::Make(i), kDeadline));
+        }
+    });
+    Message message{};
+    for (uint64_t i = 0; i < iterations; ++i) {
+        CHECK(buffer.TryReadFor(message, kDeadline));
+        CHECK(message.Valid(i));
+    }
+    producer.join();
+}
+
+/**
+ * @brief RingBuffer traits publishing the write index only every 32 writes or on Flush()
+ */
+struct LazyTraits : DefaultRingBufferTraits {
+    static constexpr size_t LazyPublishCount = 32;
+};
+
+void StressLazyPublish(size_t iterations) {
+    // The producer writes batches shorter than LazyPublishCount and never flushes, then waits for the
+    // consumer to take them: a waiting read has to claim the pending elements, whether it finds them
+    // before parking or is woken by a write made while it is parked
+    RingBuffer<Message, 64, LazyTraits> buffer;
+    Message message{};
+    for (uint64_t i = 0; i < 3; ++i) {
+        CHECK(buffer.Write(Message::Make(i)));
+    }
+    CHECK(!buffer.Read(message));
+    for (uint64_t i = 0; i < 3; ++i) {
+        CHECK(buffer.TryReadFor(message, std::chrono::milliseconds(100)));
+        CHECK(message.Valid(i));
+    }
+    CHECK(buffer.Size() == 0);
+    buffer.Flush();
+
+    std::atomic<uint64_t> taken{3};
+    std::thread producer([&] {
+        for (uint64_t i = 3; i < iterations;) {
+            const auto end = std::min<uint64_t>(iterations, i + 1 + i % 31);
+            for (; i < end; ++i) {
+                CHECK(buffer.Write(Message::Make(i)));
+            }
+            Retry([&] { return taken.load(std::memory_order_acquire) == end; });
+        }
+    });
+    for (uint64_t i = 3; i < iterations; ++i) {
+        CHECK(buffer.TryReadFor(message, kDeadline));
+        CHECK(message.Valid(i));
+        taken.store(i + 1, std::memory_order_release);
+    }
+    producer.join();
+}
+
+void StressByteRecords(size_t iterations) {
+    // Record lengths do not divide the capacity, so records regularly wrap through a padding record
+    ByteRingBuffer<256> buffer;
+    auto length = [](uint64_t sequence) { return static_cast<size_t>(sizeof(uint64_t) + sequence % 37); };
+    std::thread producer([&] {
+        unsigned char record[64];
+        for (uint64_t i = 0; i < iterations; ++i) {
+            std::memset(record, static_cast<int>(i & 0xff), sizeof(record));
+            std::memcpy(record, &i, sizeof(i));
+            Retry([&] { return buffer.Write(record, length(i)); });
+        }
+    });
+    uint64_t next = 0;
+    while (next < iterations) {
+        Retry([&] {
+            return buffer.Consume([&](const void* data, size_t size) {
+                CHECK(size == length(next));
+                uint64_t sequence;
+                std::memcpy(&sequence, data, sizeof(sequence));
+                CHECK(sequence == next);
+                const auto* bytes = static_cast<const unsigned char*>(data);
+                for (size_t i = sizeof(sequence); i < size; ++i) {
+                    CHECK(bytes[i] == static_cast<unsigned char>(next & 0xff));
+                }
+                ++next;
+            });
+        });
+    }
+    producer.join();
+}
+
+void StressParkingLot(size_t iterations) {
+    // Ping-pong a token: each side parks until the token is its own, then hands it over and notifies.
+    // A lost wakeup leaves both sides parked, which the deadline turns into a failure
+    ringbuffer_detail::ParkingLot lots[2];
+    std::atomic<uint64_t> token{0};
+    auto play = [&](uint64_t side) {
+        for (uint64_t turn = side; turn < 2 * iterations; turn += 2) {
+            auto mine = [&] { return token.load(std::memory_order_acquire) == turn; };
+            while (!mine()) {
+                const auto deadline = std::chrono::steady_clock::now() + kDeadline;
+                if (!lots[side].Park(mine, &deadline) && !mine()) {
+                    CHECK(std::chrono::steady_clock::now() < deadline);
+                }
+            }
+            token.store(turn + 1, std::memory_order_release);
+            lots[1 - side].Notify();
+        }
+    };
+    std::thread other(play, 1);
+    play(0);
+    other.join();
+    CHECK(token.load() == 2 * iterations);
+}
+
+#if defined(__linux__)
+void StressNotificationFd(size_t iterations) {
+    // Every ready poll needs a publish that wrote the fd, so more ready results than messages means
+    // the fd was left readable while armed and an epoll loop would spin. Once drained and re-armed
+    // with the producer gone, the fd must not poll readable at all
+    RingBuffer<uint64_t, 8> buffer;
+    pollfd descriptor{buffer.EnableNotificationFd(), POLLIN, 0};
+    CHECK(descriptor.fd >= 0);
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            Retry([&] { return buffer.Write(i); });
+        }
+    });
+    const auto timeout = static_cast<int>(std::chrono::milliseconds(kDeadline).count());
+    uint64_t value = 0;
+    size_t readyPolls = 0;
+    for (uint64_t next = 0; next < iterations;) {
+        if (buffer.Read(value)) {
+            CHECK(value == next);
+            ++next;
+        } else if (buffer.PrepareToPoll()) {
+            CHECK(poll(&descriptor, 1, timeout) == 1);
+            ++readyPolls;
+        }
+    }
+    producer.join();
+    CHECK(readyPolls <= iterations);
+    CHECK(buffer.PrepareToPoll());
+    CHECK(poll(&descriptor, 1, 0) == 0);
+}
+#endif
+
+/**
+ * @brief Run producers and consumers over a multi-producer or multi-consumer queue and check every delivery
+ * @param producers The number of producer threads
+ * @param consumers The number of consumer threads
+ * @param iterations The number of messages each producer sends
+ * @param write Called as write(producer, message) until it returns true
+ * @param read Called as read(consumer, message), returns whether it got a message
+ */
+template <typename Write, typename Read>
+void StressMany(size_t producers, size_t consumers, size_t iterations, Write&& write, Read&& read) {
+    Deliveries deliveries(producers, iterations);
+    std::vector<Deliveries::Consumer> states(consumers, Deliveries::Consumer(producers));
+    std::atomic<uint64_t> remaining{producers * iterations};
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                const auto message = Message::Make(p * iterations + i);
+                Retry([&] { return write(p, message); });
+            }
+        });
+    }
+    for (size_t c = 0; c < consumers; ++c) {
+        threads.emplace_back([&, c] {
+            Message message{};
+            auto step = [&] {
+                if (read(c, message)) {
+                    deliveries.Receive(states[c], message);
+                    remaining.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+                // A consumer whose peers took the rest is done too
+                return remaining.load(std::memory_order_relaxed) == 0;
+            };
+            while (remaining.load(std::memory_order_relaxed) != 0) {
+                Retry(step);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (const auto& state : states) {
+        deliveries.Merge(state);
+    }
+    CHECK(deliveries.Complete());
+}
+
+void StressMPMC(size_t iterations) {
+    MPMCRingBuffer<Message, 16> buffer;
+    StressMany(
+        3, 2, iterations, [&](size_t, const Message& message) { return buffer.Write(message); },
+        [&](size_t, Message& message) { return buffer.Read(message); });
+}
+
+void StressMPSC(size_t iterations) {
+    MPSCRingBuffer<Message, 16> buffer;
+    StressMany(
+        3, 1, iterations, [&](size_t, const Message& message) { return buffer.Write(message); },
+        [&](size_t, Message& message) { return buffer.Read(message); });
+}
+
+void StressSharded(size_t iterations) {
+    // More shards than producers, and consumers that steal from every shard but their home one
+    ShardedRingBuffer<Message, 16> buffer(4);
+    std::vector<ShardedRingBuffer<Message, 16>::ProducerToken> tokens;
+    for (size_t p = 0; p < 3; ++p) {
+        tokens.push_back(buffer.AcquireProducer());
+        CHECK(tokens.back().Valid());
+    }
+    StressMany(
+        3, 2, iterations, [&](size_t p, const Message& message) { return buffer.Write(tokens[p], message); },
+        [&](size_t c, Message& message) { return buffer.Read(c, message); });
+}
+
+void StressOverwrite(size_t iterations) {
+    // The consumer may be lapped, but whatever it reads must be whole, and lost must account exactly
+    // for the gap. The last element is never overwritten, so the consumer ends on it
+    OverwriteRingBuffer<Message, 8> buffer;
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            CHECK(buffer.Write(Message::Make(i)));
+        }
+    });
+    Message message{};
+    for (uint64_t next = 0; next < iterations;) {
+        size_t lost = 0;
+        Retry([&] { return buffer.Read(message, lost); });
+        CHECK(message.Valid(next + lost));
+        next += lost + 1;
+    }
+    producer.join();
+}
+
+void StressBroadcast(size_t iterations) {
+    // Every consumer sees every element in order, and a lossy consumer sees whole elements and exact
+    // loss counts as with OverwriteRingBuffer
+    constexpr size_t Consumers = 3;
+    BroadcastRingBuffer<Message, 16> lossless(Consumers);
+    BroadcastRingBuffer<Message, 16, true> lossy(Consumers);
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            Retry([&] { return lossless.Write(Message::Make(i)); });
+            CHECK(lossy.Write(Message::Make(i)));
+        }
+    });
+    std::vector<std::thread> consumers;
+    for (size_t c = 0; c < Consumers; ++c) {
+        consumers.emplace_back([&, c] {
+            Message message{};
+            for (uint64_t i = 0; i < iterations; ++i) {
+                Retry([&] { return lossless.Read(c, message); });
+                CHECK(message.Valid(i));
+            }
+            for (uint64_t next = 0; next < iterations;) {
+                size_t lost = 0;
+                Retry([&] { return lossy.Read(c, message, lost); });
+                CHECK(message.Valid(next + lost));
+                next += lost + 1;
+            }
+        });
+    }
+    producer.join();
+    for (auto& consumer : consumers) {
+        consumer.join();
+    }
+}
+
+void StressUnbounded(size_t iterations) {
+    // Small segments and pool, so the producer keeps linking segments and reusing drained ones
+    UnboundedRingBuffer<Message, 16, 2> buffer;
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            CHECK(buffer.Write(Message::Make(i)));
+            if (i % 64 == 0) {
+                // Let the consumer catch up now and then, so drained segments come back through the pool
+                std::this_thread::yield();
+            }
+        }
+    });
+    Message message{};
+    for (uint64_t i = 0; i < iterations; ++i) {
+        Retry([&] { return buffer.Read(message); });
+        CHECK(message.Valid(i));
+    }
+    producer.join();
+}
+
+void StressPriority(size_t iterations) {
+    // Element i goes to lane i % Lanes, so each lane must hand out its own elements in order while
+    // the consumer alternates strict priority and weighted reads
+    constexpr size_t Lanes = 3;
+    PriorityRingBuffer<Message, 16, Lanes> buffer;
+    buffer.SetWeight(0, 4);
+    buffer.SetWeight(1, 2);
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            Retry([&] { return buffer.Write(i % Lanes, Message::Make(i)); });
+        }
+    });
+    uint64_t next[Lanes] = {0, 1, 2};
+    Message message{};
+    for (uint64_t i = 0; i < iterations; ++i) {
+        Retry([&] { return i % 2 == 0 ? buffer.Read(message) : buffer.ReadWeighted(message); });
+        auto& expected = next[message.sequence % Lanes];
+        CHECK(message.Valid(expected));
+        expected += Lanes;
+    }
+    producer.join();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    StressSingle(iterations);
+    std::printf("single      ok\n");
+    StressBulk(iterations);
+    std::printf("bulk        ok\n");
+    StressConsume(iterations);
+    std::printf("consume     ok\n");
+    StressBlocking(iterations / 10);
+    std::printf("blocking    ok\n");
+    StressLazyPublish(iterations / 10);
+    std::printf("lazy        ok\n");
+    StressByteRecords(iterations);
+    std::printf("byte ring   ok\n");
+    StressParkingLot(iterations / 10);
+    std::printf("parking lot ok\n");
+#if defined(__linux__)
+    StressNotificationFd(iterations);
+    std::printf("eventfd     ok\n");
+#endif
+    StressMPMC(iterations / 3);
+    std::printf("mpmc        ok\n");
+    StressMPSC(iterations / 3);
+    std::printf("mpsc        ok\n");
+    StressSharded(iterations / 3);
+    std::printf("sharded     ok\n");
+    StressOverwrite(iterations);
+    std::printf("overwrite   ok\n");
+    StressBroadcast(iterations);
+    std::printf("broadcast   ok\n");
+    StressUnbounded(iterations);
+    std::printf("unbounded   ok\n");
+    StressPriority(iterations);
+    std::printf("priority    ok\n");
+    return 0;
+}